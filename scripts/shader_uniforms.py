@@ -1,5 +1,5 @@
 import re
-from dataclasses import dataclass
+from dataclasses import dataclass, replace
 import shader_structs
 from shader_structs import Struct
 
@@ -25,7 +25,8 @@ def generate_class(file_contents: str, input_filenames: list[str], structs: list
     name: str = cvt_case(file_name)
 
     uniforms = find_uniforms(file_contents)
-    out = make_class_header(name, input_filenames)
+    struct_table: dict[str, Struct] = {struct.name: struct for struct in structs}
+    out = make_class_header(name, input_filenames, uniforms, struct_table)
 
     out += "\nprivate:\n"
 
@@ -35,7 +36,7 @@ def generate_class(file_contents: str, input_filenames: list[str], structs: list
     out += "\npublic:\n"
 
     for uniform in uniforms:
-        out += expose_setter(uniform)
+        out += expose_setter(uniform, struct_table)
 
     out += make_class_footer(name)
 
@@ -68,7 +69,54 @@ def get_path_matching(paths: list[str], regex: re.Pattern):
     raise ValueError(f"Couldn't find anything matching {regex} in list of paths {paths}.")
 
 
-def make_class_header(name: str, paths: list[str]) -> str:
+# how many separate uniforms a value of this type takes up, once structs and arrays are spread out
+def leaf_count(uniform_type: shader_structs.BasicSerializable | shader_structs.Array | Struct) -> int:
+    if isinstance(uniform_type, shader_structs.Array):
+        return uniform_type.length * leaf_count(uniform_type.subtype)
+    elif isinstance(uniform_type, Struct):
+        return sum(leaf_count(member[0]) for member in uniform_type.contents)
+    else:
+        return 1
+
+
+# the GLSL name of every uniform inside one of type, in the order their locations are stored
+def leaf_names(name: str, uniform_type: shader_structs.BasicSerializable | shader_structs.Array | Struct) -> list[str]:
+    if isinstance(uniform_type, shader_structs.Array):
+        names: list[str] = []
+        for i in range(uniform_type.length):
+            names += leaf_names(f"{name}[{i}]", uniform_type.subtype)
+        return names
+    elif isinstance(uniform_type, Struct):
+        names = []
+        for member in uniform_type.contents:
+            names += leaf_names(f"{name}.{member[1]}", member[0])
+        return names
+    else:
+        return [name]
+
+
+# the type of a top level uniform; anything that isn't a struct is set in one go
+def uniform_type(uniform: Uniform, struct_table: dict[str, Struct]) -> shader_structs.BasicSerializable | shader_structs.Array | Struct:
+    base_type: shader_structs.BasicSerializable | Struct = \
+        struct_table.get(uniform.typename, shader_structs.BasicSerializable(0, 0))
+    if uniform.arraylen == -1:
+        return base_type
+    return shader_structs.Array(base_type, uniform.arraylen)
+
+
+# pointLights[0].position becomes pointLights_0_position
+def enum_name(glsl_name: str) -> str:
+    return glsl_name.replace("[", "_").replace("]", "").replace(".", "_")
+
+
+def make_class_header(name: str, paths: list[str], uniforms: list[Uniform],
+                      struct_table: dict[str, Struct]) -> str:
+    names: list[str] = []
+    for uniform in uniforms:
+        names += leaf_names(uniform.varname, uniform_type(uniform, struct_table))
+    enum_entries: str = ", ".join(enum_name(i) for i in names)
+    name_entries: str = ", ".join(f"\"{i}\"" for i in names)
+
     return f"""
     class {name+'Impl'} : public ShaderProgram {{
         private:
@@ -77,13 +125,32 @@ def make_class_header(name: str, paths: list[str]) -> str:
             // std::shared_ptr tries calling said constructor.
             struct PrivateObj {{}};
 
+        public:
+            // Every uniform in the program, with struct members and array elements spread out into
+            // their own. Indexes locations.
+            enum class Uniform : uint {{ {enum_entries} }};
+            static constexpr uint uniformCount = {len(names)};
+
+        private:
+            static constexpr std::array<const char*, uniformCount> uniformNames{{ {name_entries} }};
+
+            // looked up once, right after linking, so setting a uniform never hashes a name
+            std::array<int, uniformCount> locations;
+
         public:
             using ShaderProgram::setUniform; // see https://stackoverflow.com/a/35870151
 
             {name+'Impl'}(PrivateObj privateObj [[maybe_unused]]) : ShaderProgram(
                 \"{get_path_matching(paths, re.compile('\\.vert'))}\",
                 \"{get_path_matching(paths, re.compile('\\.frag'))}\"
-            ) {{ }}
+            ) {{
+                this->locations = this->getUniformLocations(uniformNames);
+            }}
+
+            // sets one uniform, like a single member of a struct
+            template <typename T> void setUniform(const Uniform uniform, const T& val) {{
+                this->setUniform(this->locations[(uint)uniform], val);
+            }}
 
             // only useable as a shared pointer
             static std::shared_ptr<{name+'Impl'}> make() {{
@@ -110,15 +177,24 @@ def find_uniforms(file: str) -> list[Uniform]:
 
 
 def make_struct_setter(struct: Struct) -> str:
-    func: str = f"void setUniform(const std::string& name, const {struct.name}& val) {{\n"
+    # locations points to the first of the struct's uniforms, and the rest follow in order
+    func: str = f"void setUniform(const int* locations, const {struct.name}& val) {{\n"
 
+    offset: int = 0
     for i in struct.contents:
         if isinstance(i[0], shader_structs.Array):
-            func += f"\tfor (int i = 0; i < {i[0].length}; i++) {{\n"
-            func += f"\t\tthis->setUniform(name + \".{i[1]}[\" + std::to_string(i) + \"]\", val.{i[1]}[i]);\n"
+            stride: int = leaf_count(i[0].subtype)
+            func += f"\tfor (uint i = 0; i < {i[0].length}; i++) {{\n"
+            if isinstance(i[0].subtype, Struct):
+                func += f"\t\tthis->setUniform(locations + {offset} + i * {stride}, val.{i[1]}[i]);\n"
+            else:
+                func += f"\t\tthis->setUniform(locations[{offset} + i], val.{i[1]}[i]);\n"
             func += "\t}\n"
+        elif isinstance(i[0], Struct):
+            func += f"\tthis->setUniform(locations + {offset}, val.{i[1]});\n"
         else:
-            func += f"\tthis->setUniform(name + \".{i[1]}\", val.{i[1]});\n"
+            func += f"\tthis->setUniform(locations[{offset}], val.{i[1]});\n"
+        offset += leaf_count(i[0])
 
     func += "}\n"
     return func
@@ -126,22 +202,34 @@ def make_struct_setter(struct: Struct) -> str:
 
 # provides a type-safe API wrapping that of the internal one that allows
 # arbitrary names and types
-def expose_setter(uniform: Uniform) -> str:
+def expose_setter(uniform: Uniform, struct_table: dict[str, Struct]) -> str:
     glm_type: str = cvt_type(uniform.typename)
+    # what each element is, for arrays
+    element_type = uniform_type(replace(uniform, arraylen=-1), struct_table)
+    first: str = "(uint)Uniform::" + enum_name(leaf_names(uniform.varname, uniform_type(uniform, struct_table))[0])
     func: str = ""
 
+    # structs are set from a pointer to their first location, everything else from the location
+    if isinstance(element_type, Struct):
+        def location(index: str) -> str:
+            return f"&this->locations[{first}{index}]"
+    else:
+        def location(index: str) -> str:
+            return f"this->locations[{first}{index}]"
+
     if uniform.arraylen == -1:  # is not an array
         func += f"void set{cvt_case(uniform.varname)}(const {glm_type}& val) {{\n"
-        func += f"    this->setUniform(\"{uniform.varname}\", val);\n"
+        func += f"    this->setUniform({location('')}, val);\n"
         func +=  "}\n"
     else:
         # generate a setter by index and a std::span setter
+        stride: int = leaf_count(element_type)
         func += f"void set{cvt_case(uniform.varname)}(const {glm_type}& val, const uint index) {{\n"
         func += f"    if (index >= {uniform.arraylen})\n"
         func += "        throw std::out_of_range(std::format(" \
             f"\"Attempted to set uniform {uniform.varname} " \
             f"of length {uniform.arraylen} at index {{}}\", index));\n"
-        func += f"    this->setUniform(\"{uniform.varname}[\" + std::to_string(index) + \"]\", val);\n"
+        func += f"    this->setUniform({location(f' + index * {stride}')}, val);\n"
         func += "}\n"
 
         func += f"void set{cvt_case(uniform.varname)}(const std::span<{glm_type}>& val) {{\n"
@@ -0,0 +1,1044 @@
+#include "benchmarks.hpp"
+
+#include "camera.hpp"
+#include "diskCache.hpp"
+#include "genTerrain.hpp"
+#include "heightfield.hpp"
+#include "meshBatch.hpp"
+#include "meshOptimizer.hpp"
+#include "mipChain.hpp"
+#include "model.hpp"
+#include "noiseKernel.hpp"
+#include "terrainQuadtree.hpp"
+#include "textureStreamer.hpp"
+#include "threadPool.hpp"
+#include "vertexCache.hpp"
+
+#include <boost/multi_array.hpp>
+
+#include <magic_enum/magic_enum.hpp>
+#include <PerlinNoise.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <memory>
+#include <numbers>
+#include <optional>
+#include <print>
+#include <random>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <unistd.h>
+
+// compares the raw bytes of two vectors
+template <typename T> static bool bytesEqual(const std::vector<T>& a, const std::vector<T>& b) {
+	return a.size() == b.size() and std::memcmp(a.data(), b.data(), VECTOR_SIZE_BYTES(a)) == 0;
+}
+
+// terrain generation time for 1..N threads
+static void benchTerrainThreads() {
+	constexpr glm::uvec2 samples{1024, 1024};
+	TerrainGenerator generator{123'123, glm::vec3(100, 100, 10), samples, NormalMethod::heightGrid};
+
+	std::println("Generating {}x{} terrain with 1..{} threads.", samples.x, samples.y,
+	             defaultThreadCount());
+
+	TerrainGeometry reference;
+	double baseTime = timeSeconds([&] { reference = generator.generate(1, {0, 0}); });
+	std::println("{:>7} {:>10} {:>8} {:>10}", "threads", "seconds", "speedup", "identical");
+	std::println("{:>7} {:>10.4f} {:>8.2f} {:>10}", 1, baseTime, 1., true);
+
+	for (uint threads = 2; threads <= defaultThreadCount(); threads++) {
+		TerrainGeometry geometry;
+		double time = timeSeconds([&] { geometry = generator.generate(threads, {0, 0}); });
+		bool identical = bytesEqual(geometry.verticies, reference.verticies)
+		             and bytesEqual(geometry.indicies, reference.indicies);
+		std::println("{:>7} {:>10.4f} {:>8.2f} {:>10}", threads, time, baseTime / time, identical);
+	}
+}
+
+// compares the quality and speed of the normal methods
+static void benchTerrainNormals() {
+	constexpr glm::uvec2 samples{1024, 1024};
+	constexpr glm::vec3 size{100, 100, 10};
+
+	std::println("Generating {}x{} terrain with {} threads.", samples.x, samples.y,
+	             defaultThreadCount());
+	std::println("{:>14} {:>10} {:>18}", "method", "seconds", "noise evaluations");
+
+	std::vector<TerrainGeometry> results;
+	for (NormalMethod method : magic_enum::enum_values<NormalMethod>()) {
+		TerrainGenerator generator{123'123, size, samples, method};
+		TerrainGeometry geometry;
+		double time =
+		    timeSeconds([&] { geometry = generator.generate(defaultThreadCount(), {0, 0}); });
+		std::println("{:>14} {:>10.4f} {:>18}", magic_enum::enum_name(method), time,
+		             generator.noiseEvaluations());
+		results.push_back(std::move(geometry));
+	}
+
+	// how far each method's normals are from the original method's, in degrees
+	// includes some error from packing the normals
+	const std::vector<TerrainVertex>& reference = results[0].verticies;
+	for (uint method = 1; method < results.size(); method++) {
+		const std::vector<TerrainVertex>& compared = results[method].verticies;
+		double totalAngle = 0;
+		double maxAngle = 0;
+		for (uint i = 0; i < reference.size(); i++) {
+			glm::vec3 referenceNormal = glm::normalize(reference[i].unpackNormal());
+			glm::vec3 comparedNormal = glm::normalize(compared[i].unpackNormal());
+			float cosAngle = glm::clamp(glm::dot(referenceNormal, comparedNormal), -1.f, 1.f);
+			double angle = glm::degrees(std::acos(cosAngle));
+			totalAngle += angle;
+			maxAngle = std::max(maxAngle, angle);
+		}
+		std::println("{} normals differ from {} by {:.4f}° on average, {:.4f}° at most.",
+		             magic_enum::enum_name(magic_enum::enum_value<NormalMethod>(method)),
+		             magic_enum::enum_name(magic_enum::enum_value<NormalMethod>(0)),
+		             totalAngle / reference.size(), maxAngle);
+	}
+}
+
+// NoiseKernel throughput for each backend, and its error compared to siv::PerlinNoise
+// throws if the error is too large
+static void benchNoiseKernel() {
+	constexpr uint rowLength = 4096;
+	constexpr uint rows = 1024;
+	constexpr float xScale = 0.0137f;
+	constexpr float yScale = 0.0211f;
+	// values are 0..1; gradients are checked against finite differences, so are less exact
+	constexpr double valueTolerance = 1e-5;
+	constexpr double gradientTolerance = 1e-3;
+	const siv::PerlinNoise noise{123'123};
+
+	std::println("{:>8} {:>16} {:>14} {:>14}", "backend", "samples/second", "value error",
+	             "gradient error");
+
+	// reference implementation, without gradients
+	double sivSum = 0; // so the loop isn't optimized out
+	double sivTime = timeSeconds([&] {
+		for (uint y = 0; y < rows; y++) {
+			for (uint x = 0; x < rowLength; x++) {
+				sivSum += noise.noise2D_01(x * xScale, y * yScale);
+			}
+		}
+	});
+	std::println("{:>8} {:>16.4g} {:>14} {:>14} (checksum {:.2f})", "siv",
+	             rows * rowLength / sivTime, "-", "-", sivSum);
+
+	std::vector<float> values(rowLength);
+	std::vector<float> gradientsX(rowLength);
+	std::vector<float> gradientsY(rowLength);
+	bool passed = true;
+
+	for (NoiseBackend backend : magic_enum::enum_values<NoiseBackend>()) {
+		if (not NoiseKernel::isSupported(backend)) {
+			std::println("{:>8} unsupported on this CPU", magic_enum::enum_name(backend));
+			continue;
+		}
+		NoiseKernel kernel{noise, backend};
+
+		double time = timeSeconds([&] {
+			for (uint y = 0; y < rows; y++) {
+				kernel.evaluateRow(xScale, 0, y * yScale, rowLength, values.data(),
+				                   gradientsX.data(), gradientsY.data());
+			}
+		});
+
+		// check a few rows, including negative coordinates
+		double valueError = 0;
+		double gradientError = 0;
+		for (int y = -8; y < 8; y++) {
+			float rowY = y * yScale * 31;
+			kernel.evaluateRow(xScale, -(int)rowLength / 2, rowY, rowLength, values.data(),
+			                   gradientsX.data(), gradientsY.data());
+			for (uint i = 0; i < rowLength; i++) {
+				double x = static_cast<float>((int)i - (int)rowLength / 2) * xScale;
+				constexpr double step = 1e-5;
+				double expectedX =
+				    (noise.noise2D_01(x + step, rowY) - noise.noise2D_01(x - step, rowY))
+				    / (2 * step);
+				double expectedY =
+				    (noise.noise2D_01(x, rowY + step) - noise.noise2D_01(x, rowY - step))
+				    / (2 * step);
+				valueError =
+				    std::max(valueError, std::abs(noise.noise2D_01(x, rowY) - values[i]));
+				gradientError = std::max({gradientError, std::abs(expectedX - gradientsX[i]),
+				                          std::abs(expectedY - gradientsY[i])});
+			}
+		}
+
+		std::println("{:>8} {:>16.4g} {:>14.3g} {:>14.3g}", magic_enum::enum_name(backend),
+		             rows * rowLength / time, valueError, gradientError);
+		if (valueError > valueTolerance or gradientError > gradientTolerance) passed = false;
+	}
+
+	if (not passed)
+		throw std::runtime_error(std::format(
+		    "NoiseKernel doesn't match siv::PerlinNoise (tolerances: value {}, gradient {}).",
+		    valueTolerance, gradientTolerance));
+}
+
+// generation time with a cold and a warm heightfield cache
+static void benchTerrainCache() {
+	if (not getCacheDir().has_value())
+		throw std::runtime_error("Caching is off, so there's nothing to benchmark.");
+
+	constexpr glm::uvec2 samples{1024, 1024};
+	TerrainGenerator generator{123'123, glm::vec3(100, 100, 10), samples, NormalMethod::heightGrid};
+	filesystem::remove(cachePath("terrain", generator.cacheKey({0, 0}), "hfld"));
+
+	TerrainGeometry reference;
+	double uncachedTime =
+	    timeSeconds([&] { reference = generator.generate(defaultThreadCount(), {0, 0}); });
+	TerrainGeometry cold;
+	double coldTime =
+	    timeSeconds([&] { cold = generator.generateCached(defaultThreadCount(), {0, 0}); });
+	TerrainGeometry warm;
+	double warmTime =
+	    timeSeconds([&] { warm = generator.generateCached(defaultThreadCount(), {0, 0}); });
+
+	bool identical = bytesEqual(warm.verticies, reference.verticies)
+	             and bytesEqual(warm.indicies, reference.indicies);
+	std::println("Generating {}x{} terrain with {} threads.", samples.x, samples.y,
+	             defaultThreadCount());
+	std::println("{:>10} {:>10} {:>10}", "", "seconds", "identical");
+	std::println("{:>10} {:>10.4f} {:>10}", "uncached", uncachedTime, true);
+	std::println("{:>10} {:>10.4f} {:>10}", "cold", coldTime,
+	             bytesEqual(cold.verticies, reference.verticies));
+	std::println("{:>10} {:>10.4f} {:>10}", "warm", warmTime, identical);
+	if (not identical) throw std::runtime_error("Cached terrain doesn't match generated terrain.");
+}
+
+// size and upload time of TerrainVertex compared to the ColorVertex terrain used to use
+static void benchTerrainVertexFormat() {
+	constexpr glm::uvec2 samples{1024, 1024};
+	constexpr glm::vec3 size{100, 100, 10};
+	constexpr DSColor bottom{glm::vec3(0), glm::vec3(0)};
+	constexpr DSColor top{glm::vec3(1), glm::vec3(1)};
+	TerrainGenerator generator{123'123, size, samples, NormalMethod::heightGrid};
+	TerrainGeometry geometry = generator.generate(defaultThreadCount(), {0, 0});
+
+	// what the generator used to make, with colors blended on the CPU
+	std::vector<ColorVertex> colorVerticies;
+	colorVerticies.reserve(geometry.verticies.size());
+	for (const TerrainVertex& vertex : geometry.verticies) {
+		float blend = vertex.position.y / size.z;
+		colorVerticies.push_back({
+		    .position = vertex.position,
+		    .normal = glm::normalize(vertex.unpackNormal()),
+		    .diffuse = glm::mix(bottom.diffuse, top.diffuse, blend),
+		    .specular = glm::mix(bottom.specular, top.specular, blend),
+		});
+	}
+
+	// best of a few uploads, waiting for each to finish
+	auto uploadTime = [](const void* data, const size_t bytes) {
+		uint buffer;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		double best = std::numeric_limits<double>::max();
+		for (uint i = 0; i < 5; i++) {
+			double time = timeSeconds([&] {
+				glBufferData(GL_ARRAY_BUFFER, bytes, data, GL_STATIC_DRAW);
+				glFinish();
+			});
+			best = std::min(best, time);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDeleteBuffers(1, &buffer);
+		return best;
+	};
+
+	double colorTime = uploadTime(colorVerticies.data(), VECTOR_SIZE_BYTES(colorVerticies));
+	double compactTime =
+	    uploadTime(geometry.verticies.data(), VECTOR_SIZE_BYTES(geometry.verticies));
+
+	std::println("Uploading {} verticies.", geometry.verticies.size());
+	std::println("{:>14} {:>14} {:>10} {:>12}", "format", "bytes/vertex", "MiB", "upload (s)");
+	std::println("{:>14} {:>14} {:>10.2f} {:>12.5f}", "ColorVertex", sizeof(ColorVertex),
+	             VECTOR_SIZE_BYTES(colorVerticies) / (1024. * 1024.), colorTime);
+	std::println("{:>14} {:>14} {:>10.2f} {:>12.5f}", "TerrainVertex", sizeof(TerrainVertex),
+	             VECTOR_SIZE_BYTES(geometry.verticies) / (1024. * 1024.), compactTime);
+	std::println("Saves {} bytes per vertex ({:.0f}%), uploads {:.2f}x faster.",
+	             sizeof(ColorVertex) - sizeof(TerrainVertex),
+	             100. * (1 - (double)sizeof(TerrainVertex) / sizeof(ColorVertex)),
+	             colorTime / compactTime);
+}
+
+// triangles drawn by TerrainQuadtree as the terrain gets bigger
+static void benchTerrainLod() {
+	constexpr DSColor color{glm::vec3(1), glm::vec3(1)};
+	constexpr uint nodeSamples = 17;
+	constexpr glm::vec2 spacing{0.2, 0.2};
+	Shaders::Terrain shader = Shaders::TerrainImpl::make();
+	Camera camera{{1280, 720}};
+
+	std::println("{:>6} {:>10} {:>10} {:>14} {:>10}", "levels", "size", "build (s)",
+	             "full triangles", "drawn");
+	for (uint levels = 3; levels <= 7; levels++) {
+		std::unique_ptr<TerrainQuadtree> terrain;
+		double time = timeSeconds([&] {
+			terrain = std::make_unique<TerrainQuadtree>(123'123, 32, color, color, spacing, 1,
+			                                            nodeSamples, levels,
+			                                            NormalMethod::heightGrid, 2, shader);
+		});
+
+		// the camera is above the middle, like it would be when walking around
+		glm::vec2 size = terrain->getSize();
+		ulong drawn = terrain->select(camera, {size.x / 2, 2, size.y / 2});
+		ulong samples = (ulong)(nodeSamples - 1) << (levels - 1);
+		std::println("{:>6} {:>10.1f} {:>10.4f} {:>14} {:>10}", levels, size.x, time,
+		             samples * samples * 2, drawn);
+	}
+}
+
+// vertex cache use and index size of plain row by row grid indicies and split, reordered ones
+static void benchTerrainIndexOrder() {
+	constexpr uint cacheSize = 32;
+	std::println("FIFO cache of {} vertices, {} threads.", cacheSize, defaultThreadCount());
+	std::println("{:>7} {:>8} {:>8} {:>8} {:>8} {:>10} {:>10} {:>10}", "samples", "ACMR",
+	             "after", "ATVR", "after", "index MiB", "after", "build (s)");
+
+	for (uint samples : {65u, 257u, 1025u, 2049u}) {
+		glm::uvec2 grid{samples, samples};
+		uint vertexCount = samples * samples;
+		std::vector<uint> rowOrder = TerrainGenerator::gridIndicies(grid, defaultThreadCount());
+
+		std::optional<SplitGridIndicies> split;
+		double time = timeSeconds(
+		    [&] { split = TerrainGenerator::splitGridIndicies(grid, defaultThreadCount()); });
+
+		// what the GPU ends up fetching, once each range's baseVertex is added
+		std::vector<uint> drawn;
+		drawn.reserve(split->indicies.size());
+		for (const DrawRange& range : split->ranges) {
+			for (uint i = 0; i < range.indexCount; i++) {
+				drawn.push_back(split->indicies[range.firstIndex + i] + range.baseVertex);
+			}
+		}
+
+		VertexCacheStats before = simulateVertexCache(rowOrder, vertexCount, cacheSize);
+		VertexCacheStats after = simulateVertexCache(drawn, vertexCount, cacheSize);
+		std::println("{:>7} {:>8.3f} {:>8.3f} {:>8.3f} {:>8.3f} {:>10.2f} {:>10.2f} {:>10.4f}",
+		             samples, before.acmr, after.acmr, before.atvr, after.atvr,
+		             VECTOR_SIZE_BYTES(rowOrder) / (1024. * 1024.),
+		             VECTOR_SIZE_BYTES(split->indicies) / (1024. * 1024.), time);
+	}
+}
+
+// brush edit time as the terrain gets bigger, which shouldn't change
+static void benchTerrainBrush() {
+	constexpr DSColor color{glm::vec3(1), glm::vec3(1)};
+	constexpr float spacing = 0.1;
+	constexpr uint edits = 100;
+	const TerrainBrush brush{.mode = BrushMode::raise, .radius = 2, .strength = 0.01, .height = 0};
+	Shaders::Terrain shader = Shaders::TerrainImpl::make();
+
+	std::println("{} edits with a brush {} samples across.", edits, 2 * brush.radius / spacing);
+	std::println("{:>7} {:>10} {:>12} {:>14}", "samples", "build (s)", "edit (ms)",
+	             "verts/edit");
+	for (uint samples : {129u, 513u, 2049u}) {
+		std::unique_ptr<Terrain> terrain;
+		double buildTime = timeSeconds([&] {
+			terrain = std::make_unique<Terrain>(123'123, 32, color, color,
+			                                    glm::vec3(samples * spacing, samples * spacing, 1),
+			                                    glm::uvec2(samples), NormalMethod::heightGrid,
+			                                    shader);
+		});
+
+		// walk the brush across the middle so every edit touches fresh rows
+		ulong uploaded = 0;
+		double editTime = timeSeconds([&] {
+			for (uint i = 0; i < edits; i++) {
+				glm::vec2 center{samples * spacing * (i + 0.5f) / edits, samples * spacing / 2};
+				uploaded += terrain->applyBrush(center, brush);
+			}
+			glFinish();
+		});
+		std::println("{:>7} {:>10.4f} {:>12.4f} {:>14}", samples, buildTime,
+		             editTime / edits * 1000, uploaded / edits);
+	}
+}
+
+// How TerrainGenerator::generate built heightGrid terrain before it wrote straight into the vertex
+// buffer: column major [x][y] arrays filled row by row, then a second pass with bounds checks,
+// pushing into vectors that weren't reserved. Kept to compare against.
+static TerrainGeometry legacyGenerate(const ulong seed, const glm::vec3& size,
+                                      const glm::uvec2 samples) {
+	siv::PerlinNoise noise{seed};
+	glm::vec3 scale{size.x / samples.x, size.y / samples.y, size.z};
+	auto heightAt = [&](const int x, const int y) {
+		return (float)(noise.noise2D_01(x * scale.x, y * scale.y) * size.z);
+	};
+
+	typedef boost::multi_array_types::extent_range range;
+	boost::multi_array<float, 2> data(
+	    boost::extents[range(-1, samples.x + 1)][range(-1, samples.y + 1)]);
+	boost::multi_array<glm::vec3, 2> normals(boost::extents[samples.x][samples.y]);
+	for (int y = -1; y <= (int)samples.y; y++) {
+		for (int x = -1; x <= (int)samples.x; x++) data[x][y] = heightAt(x, y);
+	}
+	for (int y = 0; y < (int)samples.y; y++) {
+		for (int x = 0; x < (int)samples.x; x++) {
+			float slopeX = (data[x + 1][y] - data[x - 1][y]) / (2 * scale.x);
+			float slopeZ = (data[x][y + 1] - data[x][y - 1]) / (2 * scale.y);
+			normals[x][y] = glm::normalize(glm::vec3(-slopeX, 1, -slopeZ));
+		}
+	}
+
+	TerrainGeometry geometry;
+	for (uint y = 0; y < samples.y; y++) {
+		for (uint x = 0; x < samples.x; x++) {
+			geometry.verticies.push_back({
+			    .position = {(int)x * scale.x, data[x][y], (int)y * scale.y},
+			    .normal = glm::packSnorm3x10_1x2(glm::vec4(normals[x][y], 0)),
+			});
+		}
+	}
+	auto flatten = [&](const uint x, const uint y) { return y * samples.x + x; };
+	for (uint y = 0; y < samples.y - 1; y++) {
+		for (uint x = 0; x < samples.x - 1; x++) {
+			geometry.indicies.push_back(flatten(x, y + 1));
+			geometry.indicies.push_back(flatten(x + 1, y));
+			geometry.indicies.push_back(flatten(x, y));
+			geometry.indicies.push_back(flatten(x, y + 1));
+			geometry.indicies.push_back(flatten(x + 1, y + 1));
+			geometry.indicies.push_back(flatten(x + 1, y));
+		}
+	}
+	return geometry;
+}
+
+// the flat single pass builder against the old multi_array one, on one thread so only the memory
+// layout differs
+static void benchTerrainBuilder() {
+	constexpr glm::vec3 size{100, 100, 10};
+	std::println("{:>7} {:>12} {:>12} {:>8} {:>10}", "samples", "before (s)", "after (s)",
+	             "speedup", "identical");
+
+	bool allIdentical = true;
+	for (uint samples : {128u, 512u, 1024u, 2048u}) {
+		glm::uvec2 grid{samples, samples};
+		TerrainGenerator generator{123'123, size, grid, NormalMethod::heightGrid};
+
+		TerrainGeometry before;
+		double beforeTime = timeSeconds([&] { before = legacyGenerate(123'123, size, grid); });
+		TerrainGeometry after;
+		double afterTime = timeSeconds([&] { after = generator.generate(1, {0, 0}); });
+
+		bool identical = bytesEqual(before.verticies, after.verticies)
+		             and bytesEqual(before.indicies, after.indicies);
+		allIdentical = allIdentical and identical;
+		std::println("{:>7} {:>12.4f} {:>12.4f} {:>8.2f} {:>10}", samples, beforeTime, afterTime,
+		             beforeTime / afterTime, identical);
+	}
+	if (not allIdentical) throw std::runtime_error("The builders' terrain doesn't match.");
+}
+
+// Heightfield queries per second, with raycasts checked against marching along the ray
+static void benchTerrainQueries() {
+	constexpr glm::uvec2 samples{2048, 2048};
+	constexpr glm::vec3 size{200, 200, 10};
+	constexpr uint queries = 1'000'000;
+	constexpr uint rays = 10'000;
+	TerrainGenerator generator{123'123, size, samples, NormalMethod::heightGrid};
+	TerrainGeometry geometry = generator.generate(defaultThreadCount(), {0, 0});
+	std::vector<float> heights(geometry.verticies.size());
+	for (size_t i = 0; i < heights.size(); i++) heights[i] = geometry.verticies[i].position.y;
+	Heightfield heightfield{samples, glm::vec2(generator.getScale()), std::move(heights)};
+
+	// the same points and rays every run
+	std::mt19937 random{123};
+	std::uniform_real_distribution<float> unit{0, 1};
+	std::vector<glm::vec2> points(queries);
+	for (glm::vec2& point : points) point = glm::vec2(unit(random), unit(random)) * size.x;
+	// shallow, from above the highest point, like a camera looking across the terrain
+	std::vector<std::pair<glm::vec3, glm::vec3>> raysFrom(rays);
+	for (auto& [origin, direction] : raysFrom) {
+		origin = glm::vec3(unit(random) * size.x, size.z + 1, unit(random) * size.y);
+		float angle = unit(random) * 2 * std::numbers::pi_v<float>;
+		direction = glm::normalize(glm::vec3(std::cos(angle), -0.05 - unit(random) * 0.1,
+		                                     std::sin(angle)));
+	}
+
+	// keeps the compiler from throwing the results away
+	float sum = 0;
+	double heightTime = timeSeconds([&] {
+		for (const glm::vec2& point : points) sum += heightfield.heightAt(point);
+	});
+	double normalTime = timeSeconds([&] {
+		for (const glm::vec2& point : points) sum += heightfield.normalAt(point).y;
+	});
+	std::vector<std::optional<HeightfieldHit>> hits(rays);
+	double rayTime = timeSeconds([&] {
+		for (uint i = 0; i < rays; i++) {
+			hits[i] = heightfield.raycast(raysFrom[i].first, raysFrom[i].second);
+		}
+	});
+
+	// what every caller would have to do otherwise: step along the ray, half a sample at a time
+	const float step = generator.getScale().x / 2;
+	std::vector<std::optional<float>> marched(rays);
+	double marchTime = timeSeconds([&] {
+		for (uint i = 0; i < rays; i++) {
+			auto [origin, direction] = raysFrom[i];
+			for (float t = 0;; t += step) {
+				glm::vec3 position = origin + t * direction;
+				if (position.x < 0 or position.z < 0 or position.x > size.x or position.z > size.y)
+					break;
+				if (position.y <= heightfield.heightAt({position.x, position.z})) {
+					marched[i] = t;
+					break;
+				}
+			}
+		}
+	});
+
+	// marching can only overshoot by a step, and can step over thin peaks
+	uint agree = 0;
+	for (uint i = 0; i < rays; i++) {
+		if (hits[i].has_value() == marched[i].has_value()
+		    and (not hits[i] or std::abs(hits[i]->distance - *marched[i]) <= step))
+			agree++;
+	}
+
+	std::println("{}x{} heightfield, {:.1f} MiB with its pyramid. (checksum {})", samples.x,
+	             samples.y, heightfield.sizeBytes() / (1024. * 1024.), sum);
+	std::println("{:>10} {:>14}", "query", "per second");
+	std::println("{:>10} {:>14.0f}", "heightAt", queries / heightTime);
+	std::println("{:>10} {:>14.0f}", "normalAt", queries / normalTime);
+	std::println("{:>10} {:>14.0f}", "raycast", rays / rayTime);
+	std::println("{:>10} {:>14.0f}", "march", rays / marchTime);
+	std::println("Raycasts match marching for {} of {} rays.", agree, rays);
+}
+
+// bytes in every mesh of an imported model, end to end
+static std::vector<std::byte> modelBytes(const ImportedModel& model) {
+	std::vector<std::byte> bytes;
+	for (const ImportedMesh& mesh : model.meshes) {
+		for (std::span<const std::byte> part :
+		     {std::as_bytes(mesh.verticies), std::as_bytes(mesh.indicies),
+		      std::as_bytes(std::span(mesh.lods))})
+			bytes.insert(bytes.end(), ALL_OF(part));
+	}
+	return bytes;
+}
+
+// model import time through Assimp, and from the mesh cache
+static void benchModelCache() {
+	if (not getCacheDir().has_value())
+		throw std::runtime_error("Caching is off, so there's nothing to benchmark.");
+
+	const filesystem::path path = MEDIA_DIR "./backpack/backpack.obj";
+
+	// turning caching off makes importModel go through Assimp without touching the cache
+	std::optional<filesystem::path> cacheDir = getCacheDir();
+	setCacheDir(std::nullopt);
+	ImportedModel reference;
+	double assimpTime = timeSeconds([&] { reference = Model::importModel(path, false); });
+	setCacheDir(cacheDir);
+
+	// writes the cache if it isn't there yet
+	Model::importModel(path, false);
+	ImportedModel cached;
+	double cachedTime = timeSeconds([&] { cached = Model::importModel(path, false); });
+
+	bool identical = cached.cacheFile.has_value()
+	             and bytesEqual(modelBytes(cached), modelBytes(reference));
+	std::println("Importing {} ({} meshes).", path.string(), reference.meshes.size());
+	std::println("{:>10} {:>10} {:>10}", "", "seconds", "identical");
+	std::println("{:>10} {:>10.4f} {:>10}", "assimp", assimpTime, true);
+	std::println("{:>10} {:>10.4f} {:>10}", "cached", cachedTime, identical);
+	if (not identical) throw std::runtime_error("Cached model doesn't match the imported model.");
+}
+
+// every texture the model uses, once each
+static std::vector<TexturePath> modelTextures(const filesystem::path& path) {
+	std::vector<TexturePath> textures;
+	for (const ImportedMesh& mesh : Model::importModel(path, false).meshes) {
+		for (const TexturePath& texture : mesh.textures) {
+			auto samePath = [&](const TexturePath& other) { return other.path == texture.path; };
+			if (std::ranges::none_of(textures, samePath)) textures.push_back(texture);
+		}
+	}
+	return textures;
+}
+
+// decode time of a model's textures one after another, and all at once on the thread pool
+static void benchModelTextures() {
+	const filesystem::path path = MEDIA_DIR "./backpack/backpack.obj";
+	std::vector<filesystem::path> files;
+	for (const TexturePath& texture : modelTextures(path)) files.push_back(texture.path);
+
+	double serialTime = timeSeconds([&] {
+		for (const filesystem::path& file : files) DecodedImage image = decodeImage(file);
+	});
+	double parallelTime = timeSeconds([&] {
+		std::vector<std::future<DecodedImage>> decoding;
+		for (const filesystem::path& file : files) {
+			decoding.push_back(getThreadPool().submit([&file] { return decodeImage(file); }));
+		}
+		for (std::future<DecodedImage>& image : decoding) image.get();
+	});
+
+	std::println("Decoding {} textures from {} with {} threads.", files.size(), path.string(),
+	             defaultThreadCount());
+	std::println("{:>10} {:>10}", "", "seconds");
+	std::println("{:>10} {:>10.4f}", "serial", serialTime);
+	std::println("{:>10} {:>10.4f}", "parallel", parallelTime);
+}
+
+// each of a model's meshes' vertex cache use in Assimp's order and after optimizeMesh
+static void benchModelMeshOrder() {
+	const filesystem::path path = MEDIA_DIR "./backpack/backpack.obj";
+
+	// a cached model has no stats, since it was optimized when the cache was written
+	std::optional<filesystem::path> cacheDir = getCacheDir();
+	setCacheDir(std::nullopt);
+	ImportedModel model = Model::importModel(path, false);
+	setCacheDir(cacheDir);
+
+	std::println("Meshes of {}, with a FIFO cache of 32 vertices.", path.string());
+	std::println("{:>5} {:>10} {:>8} {:>8} {:>8} {:>8}", "mesh", "triangles", "ACMR", "after",
+	             "ATVR", "after");
+	size_t triangles = 0;
+	double missesBefore = 0;
+	double missesAfter = 0;
+	for (uint i = 0; i < model.meshes.size(); i++) {
+		const ImportedMesh& mesh = model.meshes[i];
+		const MeshOptimizeStats& stats = *mesh.optimized;
+		size_t meshTriangles = mesh.lods[0].indexCount / 3;
+		std::println("{:>5} {:>10} {:>8.3f} {:>8.3f} {:>8.3f} {:>8.3f}", i, meshTriangles,
+		             stats.before.acmr, stats.after.acmr, stats.before.atvr, stats.after.atvr);
+		triangles += meshTriangles;
+		missesBefore += stats.before.acmr * meshTriangles;
+		missesAfter += stats.after.acmr * meshTriangles;
+	}
+	std::println("{:>5} {:>10} {:>8.3f} {:>8.3f}", "all", triangles, missesBefore / triangles,
+	             missesAfter / triangles);
+}
+
+// triangles in each of a model's levels of detail, how far they're off, and how long they take
+static void benchModelLods() {
+	const filesystem::path path = MEDIA_DIR "./backpack/backpack.obj";
+	std::optional<filesystem::path> cacheDir = getCacheDir();
+	setCacheDir(std::nullopt);
+	ImportedModel model;
+	double importTime = timeSeconds([&] { model = Model::importModel(path, false); });
+	setCacheDir(cacheDir);
+
+	std::array<size_t, maxMeshLods> triangles{};
+	std::array<float, maxMeshLods> maxError{};
+	std::array<uint, maxMeshLods> meshes{};
+	for (const ImportedMesh& mesh : model.meshes) {
+		for (uint level = 0; level < mesh.lods.size(); level++) {
+			triangles[level] += mesh.lods[level].indexCount / 3;
+			maxError[level] = std::max(maxError[level], mesh.lods[level].error);
+			meshes[level]++;
+		}
+	}
+
+	std::println("Levels of detail of {}, imported in {:.3f} seconds.", path.string(),
+	             importTime);
+	std::println("{:>5} {:>8} {:>10} {:>10}", "level", "meshes", "triangles", "max error");
+	for (uint level = 0; level < maxMeshLods; level++) {
+		if (meshes[level] == 0) break;
+		std::println("{:>5} {:>8} {:>10} {:>10.5f}", level, meshes[level], triangles[level],
+		             maxError[level]);
+	}
+}
+
+// time to get a model's textures ready to upload: decoding and building mips without the cache,
+// then mapping them from a warm cache, with and without compression
+static void benchTextureMips() {
+	if (not getCacheDir().has_value())
+		throw std::runtime_error("Caching is off, so there's nothing to benchmark.");
+
+	const filesystem::path path = MEDIA_DIR "./backpack/backpack.obj";
+	std::vector<TexturePath> textures = modelTextures(path);
+	auto loadAll = [&] {
+		size_t bytes = 0;
+		for (const TexturePath& texture : textures) {
+			bool color = texture.type == TextureType::textureDiffuse;
+			bytes += mipChainBytes(loadMipChain(texture.path, color));
+		}
+		return bytes;
+	};
+
+	double decodeTime = timeSeconds([&] {
+		for (const TexturePath& texture : textures) DecodedImage image = decodeImage(texture.path);
+	});
+
+	std::println("Loading {} textures from {} on one thread.", textures.size(), path.string());
+	std::println("Decoding alone takes {:.4f} seconds.", decodeTime);
+	std::println("{:>12} {:>10} {:>10} {:>10}", "", "built", "cached", "MiB");
+	std::optional<filesystem::path> cacheDir = getCacheDir();
+	const bool compress = getTextureCompression();
+	for (bool compressed : {false, true}) {
+		setTextureCompression(compressed);
+
+		setCacheDir(std::nullopt);
+		size_t bytes = 0;
+		double builtTime = timeSeconds([&] { bytes = loadAll(); });
+		setCacheDir(cacheDir);
+
+		// writes the cache if it isn't there yet
+		loadAll();
+		double cachedTime = timeSeconds(loadAll);
+
+		std::println("{:>12} {:>10.4f} {:>10.4f} {:>10.1f}",
+		             compressed ? "compressed" : "uncompressed", builtTime, cachedTime,
+		             bytes / 1024.0 / 1024.0);
+	}
+	setTextureCompression(compress);
+}
+
+// Worst frame time uploading a model's textures all at once, and streaming them through the
+// texture streamer. The streamed ones can be sampled after the first frame.
+static void benchTextureStreaming() {
+	const filesystem::path path = MEDIA_DIR "./backpack/backpack.obj";
+	std::vector<std::shared_future<MipChain>> chains;
+	for (const TexturePath& texture : modelTextures(path)) {
+		bool color = texture.type == TextureType::textureDiffuse;
+		auto load = [file = texture.path, color] { return loadMipChain(file, color); };
+		chains.push_back(getThreadPool().submit(load).share());
+	}
+	for (auto& chain : chains) chain.wait();
+
+	// each texture on its own frame, like they'd be without streaming
+	double blockingWorst = 0;
+	for (auto& chain : chains) {
+		uint texture;
+		double time = timeSeconds([&] {
+			texture = uploadMipChain(chain.get());
+			glFinish();
+		});
+		blockingWorst = std::max(blockingWorst, time);
+		glDeleteTextures(1, &texture);
+	}
+
+	TextureStreamer streamer{getTextureStreamer().getBudget()};
+	std::vector<std::shared_ptr<GpuTexture>> textures;
+	double streamingWorst = timeSeconds([&] {
+		for (auto& chain : chains) textures.push_back(streamer.upload(chain));
+		glFinish();
+	});
+	uint frames = 1;
+	while (not streamer.isIdle()) {
+		double time = timeSeconds([&] {
+			streamer.update();
+			glFinish();
+		});
+		streamingWorst = std::max(streamingWorst, time);
+		frames++;
+	}
+	textures.clear();
+	streamer.clear();
+
+	std::println("Uploading {} textures from {}, streaming {:.1f} MiB per frame.", chains.size(),
+	             path.string(), streamer.getBudget() / 1024.0 / 1024.0);
+	std::println("{:>10} {:>16} {:>8}", "", "worst frame (ms)", "frames");
+	std::println("{:>10} {:>16.2f} {:>8}", "blocking", blockingWorst * 1000, chains.size());
+	std::println("{:>10} {:>16.2f} {:>8}", "streaming", streamingWorst * 1000, frames);
+}
+
+// resident set size of this process
+static size_t residentBytes() {
+	std::ifstream statm{"/proc/self/statm"};
+	size_t pages;
+	size_t resident;
+	statm >> pages >> resident;
+	return resident * sysconf(_SC_PAGESIZE);
+}
+
+// size of a model's meshes as TexVertex and PackedTexVertex, and how far off packing them is
+static void benchModelVertexFormat() {
+	ImportedModel imported = Model::importModel(MEDIA_DIR "./backpack/backpack.obj", false);
+
+	size_t fullBytes = 0;
+	size_t packedBytes = 0;
+	// position error is relative to the mesh's size, so it's comparable between meshes
+	float positionError = 0;
+	float normalError = 0; // in degrees
+	float texCoordError = 0;
+	for (const ImportedMesh& mesh : imported.meshes) {
+		PackedTexVerticies packed = packTexVerticies(mesh.verticies);
+		MeshBounds bounds = meshBounds(mesh.verticies);
+		for (uint i = 0; i < mesh.verticies.size(); i++) {
+			const TexVertex& original = mesh.verticies[i];
+			const PackedTexVertex& vertex = packed.verticies[i];
+			glm::vec3 position = packed.dequantize * glm::vec4(vertex.unpackPosition(), 1);
+			float cosine = glm::dot(glm::normalize(vertex.unpackNormal()), original.normal);
+			positionError = std::max(positionError,
+			                         glm::distance(position, original.position) / bounds.radius);
+			normalError = std::max(normalError, glm::degrees(std::acos(std::min(cosine, 1.f))));
+			texCoordError = std::max(
+			    texCoordError, glm::distance(vertex.unpackTexCoords(), original.texCoords));
+		}
+
+		size_t indexSize = mesh.verticies.size() <= 65536 ? sizeof(ushort) : sizeof(uint);
+		fullBytes += mesh.verticies.size_bytes() + mesh.indicies.size_bytes();
+		packedBytes += VECTOR_SIZE_BYTES(packed.verticies) + mesh.indicies.size() * indexSize;
+	}
+
+	std::println("{} meshes.", imported.meshes.size());
+	std::println("{:>16} {:>14} {:>10}", "", "bytes/vertex", "MiB");
+	std::println("{:>16} {:>14} {:>10.2f}", "TexVertex", sizeof(TexVertex),
+	             fullBytes / (1024. * 1024.));
+	std::println("{:>16} {:>14} {:>10.2f}", "PackedTexVertex", sizeof(PackedTexVertex),
+	             packedBytes / (1024. * 1024.));
+	std::println("Max error: position {:.2e} of the mesh's radius, normal {:.3f} degrees, "
+	             "texture coordinates {:.2e}.",
+	             positionError, normalError, texCoordError);
+}
+
+// time to draw a model's meshes each with their own buffers, and all from one batch
+static void benchModelBatch() {
+	constexpr uint frames = 200;
+	Shaders::Object shader = Shaders::ObjectImpl::make();
+	Camera camera{{1280, 720}};
+	ImportedModel imported = Model::importModel(MEDIA_DIR "./backpack/backpack.obj", false);
+
+	// no textures, so both only differ in how the geometry is bound
+	std::vector<std::unique_ptr<Mesh<TexVertex, Shaders::Object>>> meshes;
+	std::vector<BatchedMesh> batched;
+	for (const ImportedMesh& mesh : imported.meshes) {
+		meshes.push_back(std::make_unique<Mesh<TexVertex, Shaders::Object>>(
+		    mesh.verticies, mesh.indicies, std::vector<Texture>{}, mesh.shininess, shader,
+		    mesh.lods));
+		batched.push_back({mesh.verticies, mesh.indicies, mesh.lods, {}, mesh.shininess});
+	}
+	MeshBatch batch{batched, shader};
+
+	// mean frame time, waiting for the GPU at the end of each
+	auto frameTime = [&](const std::function<void()>& draw) {
+		draw();
+		glFinish();
+		double time = timeSeconds([&] {
+			for (uint i = 0; i < frames; i++) {
+				draw();
+				glFinish();
+			}
+		});
+		return time / frames;
+	};
+	const SceneCascade cascade{glm::mat4(1)};
+	double separateTime =
+	    frameTime([&] { for (auto& mesh : meshes) mesh->render(camera, cascade); });
+	double batchTime = frameTime([&] { batch.render(camera, cascade); });
+
+	std::println("Drawing {} meshes, {} frames each.", meshes.size(), frames);
+	std::println("{:>10} {:>10} {:>12} {:>12}", "", "VAO binds", "programs", "frame (ms)");
+	std::println("{:>10} {:>10} {:>12} {:>12.3f}", "separate", meshes.size(), meshes.size(),
+	             separateTime * 1000);
+	std::println("{:>10} {:>10} {:>12} {:>12.3f}", "batched", 1, 1, batchTime * 1000);
+}
+
+// time to set a frame's uniforms through the generated location table, and by name like before
+static void benchUniforms() {
+	constexpr uint frames = 100'000;
+	constexpr uint meshes = 20;
+	Shaders::Object shader = Shaders::ObjectImpl::make();
+	shader->use();
+	int program;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+
+	const Shaders::DirectionalLight dirLight{};
+	const Shaders::SpotLight spotLight{};
+	std::vector<Shaders::PointLight> pointLights(4);
+	const glm::mat4 transform{1};
+
+	// the lights once, then the transforms for each mesh
+	double tableTime = timeSeconds([&] {
+		for (uint frame = 0; frame < frames; frame++) {
+			shader->setDirLight(dirLight);
+			shader->setPointLights(pointLights);
+			shader->setSpotLight(spotLight);
+			for (uint mesh = 0; mesh < meshes; mesh++) {
+				shader->setObj2world(transform);
+				shader->setObj2normal(glm::mat3(transform));
+				shader->setUniform(Shaders::ObjectImpl::Uniform::material_shininess, 32.f);
+			}
+		}
+	});
+
+	// the same uniforms, with names built each time and looked up in a cache
+	std::unordered_map<std::string, int> cache;
+	auto location = [&](const std::string& name) {
+		auto found = cache.find(name);
+		if (found != cache.end()) return found->second;
+		return cache[name] = glGetUniformLocation(program, name.c_str());
+	};
+	auto setVec3 = [&](const std::string& name, const glm::vec3& value) {
+		glUniform3f(location(name), value.x, value.y, value.z);
+	};
+	auto setFloat = [&](const std::string& name, const float value) {
+		glUniform1f(location(name), value);
+	};
+	double namedTime = timeSeconds([&] {
+		for (uint frame = 0; frame < frames; frame++) {
+			setVec3("dirLight.direction", dirLight.direction);
+			setVec3("dirLight.ambient", dirLight.ambient);
+			setVec3("dirLight.diffuse", dirLight.diffuse);
+			setVec3("dirLight.specular", dirLight.specular);
+			for (uint i = 0; i < pointLights.size(); i++) {
+				const std::string name = "pointLights[" + std::to_string(i) + "]";
+				setVec3(name + ".position", pointLights[i].position);
+				setVec3(name + ".ambient", pointLights[i].ambient);
+				setVec3(name + ".diffuse", pointLights[i].diffuse);
+				setVec3(name + ".specular", pointLights[i].specular);
+				setFloat(name + ".constant", pointLights[i].constant);
+				setFloat(name + ".linear", pointLights[i].linear);
+				setFloat(name + ".quadratic", pointLights[i].quadratic);
+			}
+			setVec3("spotLight.position", spotLight.position);
+			setVec3("spotLight.direction", spotLight.direction);
+			setVec3("spotLight.ambient", spotLight.ambient);
+			setVec3("spotLight.diffuse", spotLight.diffuse);
+			setVec3("spotLight.specular", spotLight.specular);
+			setFloat("spotLight.constant", spotLight.constant);
+			setFloat("spotLight.linear", spotLight.linear);
+			setFloat("spotLight.quadratic", spotLight.quadratic);
+			setFloat("spotLight.inCutoff", spotLight.inCutoff);
+			setFloat("spotLight.outCutoff", spotLight.outCutoff);
+			for (uint mesh = 0; mesh < meshes; mesh++) {
+				glUniformMatrix4fv(location("obj2world"), 1, GL_FALSE, glm::value_ptr(transform));
+				glm::mat3 normal{transform};
+				glUniformMatrix3fv(location("obj2normal"), 1, GL_FALSE, glm::value_ptr(normal));
+				setFloat("material.shininess", 32.f);
+			}
+		}
+	});
+	shader->stopUsing();
+
+	std::println("Setting the lights and {} meshes' uniforms, {} frames.", meshes, frames);
+	std::println("{:>8} {:>14}", "", "frame (us)");
+	std::println("{:>8} {:>14.3f}", "by name", namedTime / frames * 1e6);
+	std::println("{:>8} {:>14.3f}", "table", tableTime / frames * 1e6);
+}
+
+// RAM used by meshes that keep their geometry after uploading it, and ones that don't
+static void benchMeshMemory() {
+	auto mib = [](const long bytes) { return bytes / 1024.0 / 1024.0; };
+	// what each kind of mesh keeps in its CPU copies, and how much RSS grew making it
+	std::println("{:>10} {:>12} {:>12} {:>18} {:>12}", "", "kept (MiB)", "RSS (MiB)",
+	             "kept gpuOnly (MiB)", "RSS (MiB)");
+
+	// without the cache, the geometry is in vectors, like it used to be in the meshes
+	Shaders::Object objectShader = Shaders::ObjectImpl::make();
+	std::optional<filesystem::path> cacheDir = getCacheDir();
+	setCacheDir(std::nullopt);
+	long start = residentBytes();
+	ImportedModel imported = Model::importModel(MEDIA_DIR "./backpack/backpack.obj", false);
+	setCacheDir(cacheDir);
+	std::vector<std::shared_ptr<Mesh<TexVertex, Shaders::Object>>> modelMeshes;
+	size_t modelBytes = 0;
+	for (const ImportedMesh& mesh : imported.meshes) {
+		modelMeshes.push_back(std::make_shared<Mesh<TexVertex, Shaders::Object>>(
+		    mesh.verticies, mesh.indicies, std::vector<Texture>{}, mesh.shininess, objectShader));
+		modelBytes += mesh.verticies.size_bytes() + mesh.indicies.size_bytes();
+	}
+	long keptResident = residentBytes() - start;
+	imported = {};
+	long gpuOnlyResident = residentBytes() - start;
+	// the meshes were made from spans, so they're gpuOnly and this should be 0
+	size_t gpuOnlyModelBytes = 0;
+	for (const auto& mesh : modelMeshes) gpuOnlyModelBytes += mesh->cpuBytes();
+	std::println("{:>10} {:>12.1f} {:>12.1f} {:>18.1f} {:>12.1f}", "backpack", mib(modelBytes),
+	             mib(keptResident), mib(gpuOnlyModelBytes), mib(gpuOnlyResident));
+	modelMeshes.clear();
+
+	constexpr glm::uvec2 samples{1024, 1024};
+	constexpr DSColor color{glm::vec3(1), glm::vec3(1)};
+	TerrainGenerator generator{123'123, glm::vec3(100, 100, 10), samples, NormalMethod::heightGrid};
+	Shaders::Terrain terrainShader = Shaders::TerrainImpl::make();
+	Shaders::TerrMaterial material = makeTerrainMaterial(32, color, color, 10);
+	auto terrainMesh = [&](const MeshStorage storage, size_t& cpuBytes) {
+		long before = residentBytes();
+		TerrainGeometry geometry = generator.generate(defaultThreadCount(), {0, 0});
+		SplitGridIndicies split =
+		    *TerrainGenerator::splitGridIndicies(samples, defaultThreadCount());
+		auto mesh = std::make_shared<Mesh<TerrainVertex, Shaders::Terrain, ushort>>(
+		    std::move(geometry.verticies), std::move(split.indicies), material, terrainShader,
+		    storage);
+		cpuBytes = mesh->cpuBytes();
+		return residentBytes() - before;
+	};
+	size_t keptBytes;
+	size_t gpuOnlyBytes;
+	long keptTerrain = terrainMesh(MeshStorage::keepGeometry, keptBytes);
+	long gpuOnlyTerrain = terrainMesh(MeshStorage::gpuOnly, gpuOnlyBytes);
+	std::println("{:>10} {:>12.1f} {:>12.1f} {:>18.1f} {:>12.1f}", "terrain", mib(keptBytes),
+	             mib(keptTerrain), mib(gpuOnlyBytes), mib(gpuOnlyTerrain));
+	std::println("RSS is measured from before the geometry was made, and includes the driver's "
+	             "copies.");
+}
+
+const std::map<std::string, Benchmark>& getBenchmarks() {
+	static const std::map<std::string, Benchmark> benchmarks{
+	    {"terrain-threads",
+	     {"Terrain generation time for 1..N threads", false, benchTerrainThreads}},
+	    {"terrain-normals",
+	     {"Time and difference between terrain normal methods", false, benchTerrainNormals}},
+	    {"noise-kernel",
+	     {"NoiseKernel samples/second and error against siv::PerlinNoise", false,
+	      benchNoiseKernel}},
+	    {"terrain-cache",
+	     {"Terrain generation time with a cold and warm heightfield cache", false,
+	      benchTerrainCache}},
+	    {"terrain-vertex-format",
+	     {"Size and upload time of the compact terrain vertex", true, benchTerrainVertexFormat}},
+	    {"terrain-lod",
+	     {"Triangles drawn by quadtree terrain as its size grows", true, benchTerrainLod}},
+	    {"terrain-index-order",
+	     {"Vertex cache miss ratio and size of terrain indicies before and after reordering",
+	      false, benchTerrainIndexOrder}},
+	    {"terrain-builder",
+	     {"Single threaded terrain build time before and after flattening the builder", false,
+	      benchTerrainBuilder}},
+	    {"terrain-queries",
+	     {"Terrain height, normal and raycast queries per second", false, benchTerrainQueries}},
+	    {"terrain-brush",
+	     {"Time per terrain brush edit as the terrain grows", true, benchTerrainBrush}},
+	    {"model-cache",
+	     {"Model import time through Assimp and from the mesh cache", false, benchModelCache}},
+	    {"model-textures",
+	     {"Model texture decode time one at a time and on the thread pool", false,
+	      benchModelTextures}},
+	    {"model-mesh-order",
+	     {"Vertex cache miss ratio of each model mesh before and after optimizing its order",
+	      false, benchModelMeshOrder}},
+	    {"model-lods",
+	     {"Triangles and error of each level of detail built for a model", false,
+	      benchModelLods}},
+	    {"model-vertex-format",
+	     {"Size of model meshes with packed verticies and 16 bit indicies, and their error",
+	      false, benchModelVertexFormat}},
+	    {"model-batch",
+	     {"Frame time of a model drawn as separate meshes and as one batch", true,
+	      benchModelBatch}},
+	    {"mesh-memory",
+	     {"RAM used by the backpack and terrain meshes when they keep their geometry and when "
+	      "they don't",
+	      true, benchMeshMemory}},
+	    {"texture-streaming",
+	     {"Worst frame time uploading model textures all at once and streaming them", true,
+	      benchTextureStreaming}},
+	    {"uniforms",
+	     {"Time to set a frame's uniforms from the location table and by name", true,
+	      benchUniforms}},
+	    {"texture-mips",
+	     {"Model texture load time with mips built on the CPU, and from the texture cache",
+	      false, benchTextureMips}},
+	};
+	return benchmarks;
+}
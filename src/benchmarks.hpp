@@ -0,0 +1,28 @@
+#ifndef BENCHMARKS_HPP
+#define BENCHMARKS_HPP
+
+#include "common.hpp"
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+
+struct Benchmark {
+	std::string description;
+	bool needsGL; // needs an OpenGL context to already exist
+	std::function<void()> run;
+};
+
+// all benchmarks, keyed by the name used on the command line
+const std::map<std::string, Benchmark>& getBenchmarks();
+
+// runs func once and returns how long it took in seconds
+inline double timeSeconds(const std::function<void()>& func) {
+	auto start = std::chrono::steady_clock::now();
+	func();
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(end - start).count();
+}
+
+#endif /* BENCHMARKS_HPP */
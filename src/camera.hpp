@@ -55,6 +55,8 @@ class Camera {
 		this->projectionMatCache = std::optional<glm::dmat4>();
 	}
 
+	glm::ivec2 getWindowSize() const { return this->windowSize; }
+
 	// the returned matrix tranforms world => camera space
 	glm::dmat4 toCamSpace() const;
 
@@ -0,0 +1,113 @@
+#include "diskCache.hpp"
+
+#include <cstdio>
+#include <format>
+#include <fstream>
+#include <print>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+CacheKey& CacheKey::add(const void* data, const size_t size) {
+	const uchar* bytes = static_cast<const uchar*>(data);
+	for (size_t i = 0; i < size; i++) {
+		this->hash ^= bytes[i];
+		this->hash *= 1'099'511'628'211ul;
+	}
+	return *this;
+}
+
+static std::optional<filesystem::path> cacheDir;
+
+const std::optional<filesystem::path>& getCacheDir() { return cacheDir; }
+
+void setCacheDir(const std::optional<filesystem::path>& dir) {
+	if (dir.has_value()) {
+		std::error_code error;
+		filesystem::create_directories(*dir, error);
+		if (error) {
+			std::println(stderr, "Couldn't create the cache directory {}, caching is off: {}",
+			             dir->string(), error.message());
+			cacheDir = std::nullopt;
+			return;
+		}
+	}
+	cacheDir = dir;
+}
+
+filesystem::path cachePath(const std::string_view kind, const ulong key,
+                           const std::string_view extension) {
+	if (not cacheDir.has_value()) throw std::logic_error("Caching is off.");
+	return *cacheDir / kind / std::format("{:016x}.{}", key, extension);
+}
+
+std::optional<MappedFile> MappedFile::open(const filesystem::path& path) {
+	int file = ::open(path.c_str(), O_RDONLY);
+	if (file == -1) return std::nullopt;
+
+	struct stat info;
+	if (fstat(file, &info) == -1 or info.st_size == 0) {
+		close(file);
+		return std::nullopt;
+	}
+
+	void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file); // the mapping keeps the file open
+	if (data == MAP_FAILED) return std::nullopt;
+
+	return MappedFile{static_cast<const std::byte*>(data), (size_t)info.st_size};
+}
+
+MappedFile::MappedFile(MappedFile&& other) {
+	this->data = other.data;
+	this->size = other.size;
+	other.data = NULL;
+	other.size = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+	if (this == &other) return *this;
+	if (this->data) munmap(const_cast<std::byte*>(this->data), this->size);
+	this->data = other.data;
+	this->size = other.size;
+	other.data = NULL;
+	other.size = 0;
+	return *this;
+}
+
+MappedFile::~MappedFile() {
+	if (this->data) munmap(const_cast<std::byte*>(this->data), this->size);
+}
+
+void writeCacheFile(const filesystem::path& path,
+                    const std::vector<std::span<const std::byte>>& parts) {
+	// unique per process and thread, so writers of the same file don't clobber each other's
+	filesystem::path temporary = path;
+	temporary += std::format(".{}.{}.tmp", getpid(),
+	                         std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+	std::error_code error;
+	filesystem::create_directories(path.parent_path(), error);
+	{
+		std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+		for (std::span<const std::byte> part : parts) {
+			file.write(reinterpret_cast<const char*>(part.data()), part.size());
+		}
+		if (not file) {
+			std::println(stderr, "Couldn't write cache file {}.", temporary.string());
+			filesystem::remove(temporary, error);
+			return;
+		}
+	}
+
+	filesystem::rename(temporary, path, error);
+	if (error) {
+		std::println(stderr, "Couldn't write cache file {}: {}", path.string(), error.message());
+		filesystem::remove(temporary, error);
+	}
+}
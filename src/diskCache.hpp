@@ -0,0 +1,81 @@
+#ifndef DISKCACHE_HPP
+#define DISKCACHE_HPP
+
+#include "common.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Builds a 64 bit FNV-1a hash. Unlike std::hash, it's the same on every run, so it can name files.
+class CacheKey {
+  private:
+	ulong hash;
+
+  public:
+	CacheKey() { this->hash = 14'695'981'039'346'656'037ul; }
+
+	CacheKey& add(const void* data, const size_t size);
+
+	// T shouldn't have padding, since that would be hashed too
+	// arrays are left to the string_view overload, so string literals don't include their \0
+	template <typename T>
+	    requires(std::is_trivially_copyable_v<T> and not std::is_array_v<T>)
+	CacheKey& add(const T& value) {
+		return this->add(&value, sizeof(T));
+	}
+
+	CacheKey& add(const std::string_view string) { return this->add(string.data(), string.size()); }
+
+	ulong get() const { return this->hash; }
+};
+
+// Where caches are kept, or nullopt if caching is off. Off until setCacheDir is called.
+const std::optional<filesystem::path>& getCacheDir();
+
+// Creates the directory if it doesn't exist. If it can't, warns and turns caching off instead,
+// since the caches aren't worth crashing over.
+void setCacheDir(const std::optional<filesystem::path>& dir);
+
+// where the file for key goes; each kind of cache gets its own subdirectory
+// caching must be on
+filesystem::path cachePath(const std::string_view kind, const ulong key,
+                           const std::string_view extension);
+
+// A read only memory mapped file. Move only, unmapped when destroyed.
+class MappedFile {
+  private:
+	const std::byte* data;
+	size_t size;
+
+	MappedFile(const std::byte* data, const size_t size) {
+		this->data = data;
+		this->size = size;
+	}
+
+  public:
+	// nullopt if the file doesn't exist, is empty, or can't be mapped
+	static std::optional<MappedFile> open(const filesystem::path& path);
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other);
+	MappedFile& operator=(MappedFile&& other);
+
+	const std::byte* getData() const { return this->data; }
+
+	size_t getSize() const { return this->size; }
+
+	~MappedFile();
+};
+
+// Writes parts one after another to a temporary file, then renames it over path, so readers never
+// see a half written file. Failing to write a cache isn't fatal, so this only prints a warning.
+void writeCacheFile(const filesystem::path& path,
+                    const std::vector<std::span<const std::byte>>& parts);
+
+#endif /* DISKCACHE_HPP */
@@ -2,18 +2,33 @@
 # Generated by scripts/gen_filelist.sh
 
 target_sources(prog PRIVATE
+	"./src/benchmarks.cpp"
 	"./src/camera.cpp"
+	"./src/diskCache.cpp"
 	"./src/genTerrain.cpp"
+	"./src/heightfield.cpp"
+	"./src/heightmapTerrain.cpp"
 	"./src/imguiConfig.cpp"
 	"./src/lighting.cpp"
 	"./src/main.cpp"
 	"./src/mesh.cpp"
+	"./src/meshBatch.cpp"
+	"./src/meshOptimizer.cpp"
+	"./src/mipChain.cpp"
 	"./src/model.cpp"
+	"./src/noiseKernel.cpp"
+	"./src/resourceManager.cpp"
 	"./src/sceneConf.cpp"
 	"./src/sceneObject.cpp"
 	"./src/sdlConfig.cpp"
 	"./src/shaders.cpp"
+	"./src/startupReport.cpp"
 	"./src/stbImageBuild.cpp"
+	"./src/terrainQuadtree.cpp"
+	"./src/terrainStreamer.cpp"
+	"./src/textureStreamer.cpp"
+	"./src/threadPool.cpp"
+	"./src/vertexCache.cpp"
 	"./src/vertexData.cpp"
 )
 
@@ -1,35 +1,43 @@
 #include "genTerrain.hpp"
 
+#include "diskCache.hpp"
 #include "glmFormatters.hpp"
+#include "threadPool.hpp"
+#include "vertexCache.hpp"
 
 #include <glm/geometric.hpp>
 
-glm::vec3 Terrain::pointFromData(const boost::multi_array<float, 2>& data, const glm::uvec2 point,
-                                 const glm::vec3 scale, const float fallback) {
-	float value;
-	if (point.x >= 0 and point.x < data.shape()[0] and point.y >= 0 and point.y < data.shape()[1])
-		value = data[point.x][point.y];
-	else value = fallback;
-	return {point.x * scale.x, value, point.y * scale.y};
-}
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <numeric>
+
+// start of a heightfield cache file, followed by samples.x * samples.y heights, then as many packed
+// normals, both row major
+struct HeightfieldHeader {
+	std::array<char, 4> magic;
+	uint version;
+	ulong key;
+	glm::uvec2 samples;
+};
+
+static constexpr std::array<char, 4> heightfieldMagic{'H', 'F', 'L', 'D'};
 
-glm::vec3 Terrain::pointAt(const glm::vec2& pos) {
+glm::vec3 TerrainGenerator::pointAt(const glm::vec2& pos) const {
 	return {pos.x, this->noise.noise2D_01(pos.x, pos.y) * this->size.z, pos.y};
 }
 
-Mesh<ColorVertex, Shaders::Terrain> Terrain::getTerrain() {
-	glm::vec3 scale = {this->size.x / this->samples.x, this->size.y / this->samples.y,
-	                   this->size.z};
-	boost::multi_array<float, 2> terrainData(boost::extents[this->samples.x][this->samples.y]);
-	boost::multi_array<glm::vec3, 2> terrainNormals(
-	    boost::extents[this->samples.x][this->samples.y]);
+void TerrainGenerator::perlinSampleRows(TerrainVertex* verticies, const uint yBegin,
+                                        const uint yEnd, const glm::ivec2 offset,
+                                        const glm::vec3 scale) const {
+	// a small number
+	const float small = fmin(this->size.x / this->samples.x, this->size.y / this->samples.y) / 10;
 
-	for (uint y = 0; y < this->samples.y; y++) {
+	for (uint y = yBegin; y < yEnd; y++) {
+		TerrainVertex* row = verticies + (size_t)y * this->samples.x;
 		for (uint x = 0; x < this->samples.x; x++) {
-			glm::vec3 position = this->pointAt({x * scale.x, y * scale.y});
-			terrainData[x][y] = position.y;
-			// a small number
-			float small = fmin(this->size.x / this->samples.x, this->size.y / this->samples.y) / 10;
+			glm::vec3 position =
+			    this->pointAt({(offset.x + (int)x) * scale.x, (offset.y + (int)y) * scale.y});
 
 			// stored clockwise
 			std::array<glm::vec3, 4> nearbyPoints{
@@ -58,46 +66,358 @@ Mesh<ColorVertex, Shaders::Terrain> Terrain::getTerrain() {
 			// average the array
 			glm::vec3 averageNormal =
 			    glm::normalize(std::accumulate(ALL_OF(normalsWith), glm::vec3(0)));
-			terrainNormals[x][y] = averageNormal;
+			row[x] = {position, glm::packSnorm3x10_1x2(glm::vec4(averageNormal, 0))};
+		}
+	}
+}
+
+void TerrainGenerator::heightGridRows(TerrainVertex* verticies, const float* heights,
+                                      const uint yBegin, const uint yEnd, const glm::ivec2 offset,
+                                      const glm::vec3 scale) const {
+	const uint stride = this->samples.x + 2;
+
+	// central differences; every sample has neighbors thanks to the border
+	for (uint y = yBegin; y < yEnd; y++) {
+		TerrainVertex* row = verticies + (size_t)y * this->samples.x;
+		// the border is at -1, so row y starts at (y + 1, 1)
+		const float* above = heights + (size_t)y * stride + 1;
+		const float* middle = above + stride;
+		const float* below = middle + stride;
+		const float* left = middle - 1;
+		const float* right = middle + 1;
+		for (uint x = 0; x < this->samples.x; x++) {
+			float slopeX = (right[x] - left[x]) / (2 * scale.x);
+			float slopeZ = (below[x] - above[x]) / (2 * scale.y);
+			// cross product of the tangents (0, slopeZ, 1) and (1, slopeX, 0)
+			glm::vec3 normal = glm::normalize(glm::vec3(-slopeX, 1, -slopeZ));
+			row[x] = {this->positionAt({x, y}, offset, scale, middle[x]),
+			          glm::packSnorm3x10_1x2(glm::vec4(normal, 0))};
 		}
 	}
+}
 
-	std::vector<ColorVertex> verticies;
+void TerrainGenerator::analyticRows(TerrainVertex* verticies, const uint yBegin, const uint yEnd,
+                                    const glm::ivec2 offset, const glm::vec3 scale) const {
+	std::vector<float> values(this->samples.x);
+	std::vector<float> gradientsX(this->samples.x);
+	std::vector<float> gradientsY(this->samples.x);
 
-	for (uint y = 0; y < this->samples.y; y++) {
+	for (uint y = yBegin; y < yEnd; y++) {
+		TerrainVertex* row = verticies + (size_t)y * this->samples.x;
+		this->noiseKernel.evaluateRow(scale.x, offset.x, (offset.y + (int)y) * scale.y,
+		                              this->samples.x, values.data(), gradientsX.data(),
+		                              gradientsY.data());
 		for (uint x = 0; x < this->samples.x; x++) {
-			glm::vec3 position = this->pointFromData(terrainData, {x, y}, scale);
-			glm::vec3 normal = terrainNormals[x][y];
-
-			glm::vec3 diffuse =
-			    glm::mix(this->bottomColor.diffuse, this->topColor.diffuse, position.y / scale.z);
-			glm::vec3 specular =
-			    glm::mix(this->bottomColor.specular, this->topColor.specular, position.y / scale.z);
-
-			verticies.push_back(ColorVertex{
-			    .position = position,
-			    .normal = normal, // TODO: fix artifacts in normals with strange X patterns
-			    .diffuse = diffuse,
-			    .specular = specular,
-			});
+			// noise coordinates are world coordinates, so only the height needs scaling
+			float slopeX = gradientsX[x] * this->size.z;
+			float slopeZ = gradientsY[x] * this->size.z;
+			glm::vec3 normal = glm::normalize(glm::vec3(-slopeX, 1, -slopeZ));
+			row[x] = {this->positionAt({x, y}, offset, scale, values[x] * this->size.z),
+			          glm::packSnorm3x10_1x2(glm::vec4(normal, 0))};
 		}
 	}
+}
+
+ulong TerrainGenerator::noiseEvaluations() const {
+	ulong samples = (ulong)this->samples.x * this->samples.y;
+	switch (this->normalMethod) {
+	case NormalMethod::perlinSamples: return samples * 5;
+	case NormalMethod::heightGrid: return (this->samples.x + 2ul) * (this->samples.y + 2ul);
+	case NormalMethod::analytic: return samples;
+	}
+	std::unreachable();
+}
+
+TerrainGeometry TerrainGenerator::generate(const uint threads, const glm::ivec2 offset) const {
+	const glm::vec3 scale = this->getScale();
+	// presized so each row can be written independently, and written in place so it can go
+	// straight into a vertex buffer
+	std::vector<TerrainVertex> verticies((size_t)this->samples.x * this->samples.y);
+
+	// heightGrid needs every neighbor's height first, including the border
+	std::vector<float> heights;
+	if (this->normalMethod == NormalMethod::heightGrid)
+		heights = this->generateHeights(threads, offset);
+
+	// every row only depends on the noise and heights, so splitting by row can't change the output
+	getThreadPool().parallelFor(this->samples.y, threads, [&](const uint yBegin, const uint yEnd) {
+		switch (this->normalMethod) {
+		case NormalMethod::perlinSamples:
+			this->perlinSampleRows(verticies.data(), yBegin, yEnd, offset, scale);
+			break;
+		case NormalMethod::heightGrid:
+			this->heightGridRows(verticies.data(), heights.data(), yBegin, yEnd, offset, scale);
+			break;
+		case NormalMethod::analytic:
+			this->analyticRows(verticies.data(), yBegin, yEnd, offset, scale);
+			break;
+		}
+	});
 
-	std::vector<uint> indicies;
+	return {std::move(verticies), gridIndicies(this->samples, threads)};
+}
+
+std::vector<float> TerrainGenerator::generateHeights(const uint threads,
+                                                     const glm::ivec2 offset) const {
+	glm::vec3 scale = this->getScale();
+	const glm::uvec2 bordered = this->samples + 2u;
+	std::vector<float> heights(bordered.x * bordered.y);
+
+	getThreadPool().parallelFor(bordered.y, threads, [&](const uint yBegin, const uint yEnd) {
+		for (uint y = yBegin; y < yEnd; y++) {
+			for (uint x = 0; x < bordered.x; x++) {
+				// the border is at -1, so shift back by one
+				glm::vec2 position{(offset.x + (int)x - 1) * scale.x,
+				                   (offset.y + (int)y - 1) * scale.y};
+				heights[this->flatten({x, y}, bordered)] = this->pointAt(position).y;
+			}
+		}
+	});
+
+	return heights;
+}
+
+float TerrainGenerator::sampleHeight(const glm::ivec2 coord) const {
+	glm::vec3 scale = this->getScale();
+	return this->pointAt({coord.x * scale.x, coord.y * scale.y}).y;
+}
+
+std::vector<uint> TerrainGenerator::gridIndicies(const glm::uvec2 samples, const uint threads) {
+	auto flatten = [&](const uint x, const uint y) { return y * samples.x + x; };
+
+	// each row of squares makes 2 triangles per square
+	const uint indiciesPerRow = (samples.x - 1) * 6;
+	std::vector<uint> indicies((samples.y - 1) * indiciesPerRow);
 
 	// get triangle indicies by going square by square across the data
-	for (uint y = 0; y < this->samples.y - 1; y++) {
-		for (uint x = 0; x < this->samples.x - 1; x++) {
-			// first half of square
-			indicies.push_back(this->flatten({x, y + 1}, this->samples));
-			indicies.push_back(this->flatten({x + 1, y}, this->samples));
-			indicies.push_back(this->flatten({x, y}, this->samples));
-			// second half of square
-			indicies.push_back(this->flatten({x, y + 1}, this->samples));
-			indicies.push_back(this->flatten({x + 1, y + 1}, this->samples));
-			indicies.push_back(this->flatten({x + 1, y}, this->samples));
+	getThreadPool().parallelFor(samples.y - 1, threads, [&](const uint yBegin, const uint yEnd) {
+		for (uint y = yBegin; y < yEnd; y++) {
+			uint i = y * indiciesPerRow;
+			for (uint x = 0; x < samples.x - 1; x++) {
+				// first half of square
+				indicies[i++] = flatten(x, y + 1);
+				indicies[i++] = flatten(x + 1, y);
+				indicies[i++] = flatten(x, y);
+				// second half of square
+				indicies[i++] = flatten(x, y + 1);
+				indicies[i++] = flatten(x + 1, y + 1);
+				indicies[i++] = flatten(x + 1, y);
+			}
+		}
+	});
+
+	return indicies;
+}
+
+std::optional<SplitGridIndicies> TerrainGenerator::splitGridIndicies(const glm::uvec2 samples,
+                                                                    const uint threads) {
+	const uint rowsPerBand = std::min(65536 / samples.x, samples.y);
+	if (rowsPerBand < 2) return std::nullopt;
+
+	// first row of each band; the next band starts on this one's last row
+	std::vector<uint> bandStarts;
+	for (uint start = 0; start < samples.y - 1; start += rowsPerBand - 1) {
+		bandStarts.push_back(start);
+	}
+
+	std::vector<std::vector<uint>> bands(bandStarts.size());
+	getThreadPool().parallelFor(bands.size(), threads, [&](const uint begin, const uint end) {
+		for (uint i = begin; i < end; i++) {
+			glm::uvec2 bandSamples{samples.x, std::min(rowsPerBand, samples.y - bandStarts[i])};
+			// already relative to the band's first vertex
+			std::vector<uint> indicies = gridIndicies(bandSamples, 1);
+			bands[i] = optimizeVertexCache(indicies, bandSamples.x * bandSamples.y);
+		}
+	});
+
+	SplitGridIndicies split;
+	for (uint i = 0; i < bands.size(); i++) {
+		split.ranges.push_back({
+		    .indexCount = (uint)bands[i].size(),
+		    .firstIndex = split.indicies.size(),
+		    .baseVertex = (int)(bandStarts[i] * samples.x),
+		});
+		split.indicies.insert(split.indicies.end(), ALL_OF(bands[i]));
+	}
+	return split;
+}
+
+ulong TerrainGenerator::cacheKey(const glm::ivec2 offset) const {
+	return CacheKey()
+	    .add("heightfield")
+	    .add(version)
+	    .add(this->seed)
+	    .add(this->size)
+	    .add(this->samples)
+	    .add(this->normalMethod)
+	    .add(offset)
+	    .get();
+}
+
+TerrainGeometry TerrainGenerator::generateCached(const uint threads,
+                                                 const glm::ivec2 offset) const {
+	if (not getCacheDir().has_value()) return this->generate(threads, offset);
+
+	const ulong key = this->cacheKey(offset);
+	const filesystem::path path = cachePath("terrain", key, "hfld");
+	const size_t count = (size_t)this->samples.x * this->samples.y;
+	const HeightfieldHeader expected{heightfieldMagic, version, key, this->samples};
+
+	std::optional<MappedFile> file = MappedFile::open(path);
+	if (file.has_value()
+	    and file->getSize() == sizeof(HeightfieldHeader) + count * (sizeof(float) + sizeof(uint))
+	    and std::memcmp(file->getData(), &expected, sizeof(HeightfieldHeader)) == 0) {
+		const float* heights =
+		    reinterpret_cast<const float*>(file->getData() + sizeof(HeightfieldHeader));
+		const uint* normals = reinterpret_cast<const uint*>(heights + count);
+		const glm::vec3 scale = this->getScale();
+
+		ThreadPool& pool = getThreadPool();
+
+		std::vector<TerrainVertex> verticies(count);
+		pool.parallelFor(this->samples.y, threads, [&](const uint yBegin, const uint yEnd) {
+			for (uint y = yBegin; y < yEnd; y++) {
+				for (uint x = 0; x < this->samples.x; x++) {
+					uint i = this->flatten({x, y}, this->samples);
+					verticies[i] = TerrainVertex{
+					    .position = this->positionAt({x, y}, offset, scale, heights[i]),
+					    .normal = normals[i],
+					};
+				}
+			}
+		});
+		return {std::move(verticies), gridIndicies(this->samples, threads)};
+	}
+
+	// missing, from another version, or corrupt
+	TerrainGeometry geometry = this->generate(threads, offset);
+	std::vector<float> heights(count);
+	std::vector<uint> normals(count);
+	for (size_t i = 0; i < count; i++) {
+		heights[i] = geometry.verticies[i].position.y;
+		normals[i] = geometry.verticies[i].normal;
+	}
+	writeCacheFile(path, {
+	                         std::as_bytes(std::span(&expected, 1)),
+	                         std::as_bytes(std::span(heights)),
+	                         std::as_bytes(std::span(normals)),
+	                     });
+	return geometry;
+}
+
+void Terrain::buildMesh() {
+	const uint threads = defaultThreadCount();
+	TerrainGeometry geometry = this->generator.generateCached(threads, {0, 0});
+
+	std::vector<float> heights(geometry.verticies.size());
+	for (size_t i = 0; i < heights.size(); i++) heights[i] = geometry.verticies[i].position.y;
+	this->heightfield = Heightfield{this->generator.getSamples(),
+	                                glm::vec2(this->generator.getScale()), std::move(heights)};
+
+	std::optional<SplitGridIndicies> split =
+	    TerrainGenerator::splitGridIndicies(this->generator.getSamples(), threads);
+	if (split.has_value()) {
+		auto mesh = std::make_shared<ShortMesh>(std::move(geometry.verticies),
+		                                        std::move(split->indicies), this->material,
+		                                        this->shader, MeshStorage::gpuOnly);
+		mesh->setRanges(split->ranges);
+		this->mesh = mesh;
+		this->addChild(mesh);
+		return;
+	}
+
+	// too wide for 16 bits, but it can still be reordered
+	std::vector<uint> indicies = optimizeVertexCache(geometry.indicies, geometry.verticies.size());
+	auto mesh = std::make_shared<WideMesh>(std::move(geometry.verticies), std::move(indicies),
+	                                       this->material, this->shader, MeshStorage::gpuOnly);
+	this->mesh = mesh;
+	this->addChild(mesh);
+}
+
+uint Terrain::applyBrush(const glm::vec2& center, const TerrainBrush& brush) {
+	const glm::ivec2 samples{this->generator.getSamples()};
+	const glm::vec2 spacing{this->generator.getScale()};
+
+	// samples the brush reaches
+	glm::ivec2 brushMin = glm::max(glm::ivec2(glm::floor((center - brush.radius) / spacing)), 0);
+	glm::ivec2 brushMax =
+	    glm::min(glm::ivec2(glm::ceil((center + brush.radius) / spacing)), samples - 1);
+	if (brushMin.x > brushMax.x or brushMin.y > brushMax.y) return 0;
+
+	// the normals next to the brush change too, and need the heights next to them
+	glm::ivec2 dirtyMin = glm::max(brushMin - 1, 0);
+	glm::ivec2 dirtyMax = glm::min(brushMax + 1, samples - 1);
+	glm::ivec2 heightsMin = glm::max(brushMin - 2, 0);
+	glm::ivec2 heightsMax = glm::min(brushMax + 2, samples - 1);
+	glm::ivec2 heightsSize = heightsMax - heightsMin + 1;
+
+	// the mesh doesn't keep its verticies, so everything comes from the heightfield
+	auto index = [&](const glm::ivec2 coord) { return (size_t)coord.y * samples.x + coord.x; };
+	auto positionAt = [&](const glm::ivec2 coord, const float height) {
+		return glm::vec3(coord.x * spacing.x, height, coord.y * spacing.y);
+	};
+
+	std::vector<float> heights(heightsSize.x * heightsSize.y);
+	auto heightAt = [&](const glm::ivec2 coord) -> float& {
+		glm::ivec2 local = coord - heightsMin;
+		return heights[local.y * heightsSize.x + local.x];
+	};
+	for (int y = heightsMin.y; y <= heightsMax.y; y++) {
+		for (int x = heightsMin.x; x <= heightsMax.x; x++) {
+			heightAt({x, y}) = this->heightfield.getHeight(glm::uvec2(x, y));
+		}
+	}
+
+	for (int y = brushMin.y; y <= brushMax.y; y++) {
+		for (int x = brushMin.x; x <= brushMax.x; x++) {
+			float distance = glm::distance(glm::vec2(x, y) * spacing, center);
+			if (distance >= brush.radius) continue;
+
+			// smooth falloff, flat in the middle and at the edge
+			float falloff = 1 - (distance * distance) / (brush.radius * brush.radius);
+			falloff *= falloff;
+
+			float& height = heightAt({x, y});
+			switch (brush.mode) {
+			case BrushMode::raise: height += brush.strength * falloff; break;
+			case BrushMode::lower: height -= brush.strength * falloff; break;
+			case BrushMode::flatten:
+				height =
+				    glm::mix(height, brush.height, glm::clamp(brush.strength * falloff, 0.f, 1.f));
+				break;
+			}
 		}
 	}
 
-	return Mesh<ColorVertex, Shaders::Terrain>{verticies, indicies, this->shininess, this->shader};
+	this->heightfield.setHeights(glm::uvec2(heightsMin), glm::uvec2(heightsSize), heights.data());
+
+	// past the edges, the border generate() used for heightGrid normals; the brush never reaches it
+	auto neighborHeight = [&](const glm::ivec2 coord) {
+		if (coord.x < 0 or coord.y < 0 or coord.x >= samples.x or coord.y >= samples.y)
+			return this->generator.sampleHeight(coord);
+		return heightAt(coord);
+	};
+
+	// same as heightGridRows
+	uint uploaded = 0;
+	std::vector<TerrainVertex> row(dirtyMax.x - dirtyMin.x + 1);
+	for (int y = dirtyMin.y; y <= dirtyMax.y; y++) {
+		for (int x = dirtyMin.x; x <= dirtyMax.x; x++) {
+			float slopeX =
+			    (neighborHeight({x + 1, y}) - neighborHeight({x - 1, y})) / (2 * spacing.x);
+			float slopeZ =
+			    (neighborHeight({x, y + 1}) - neighborHeight({x, y - 1})) / (2 * spacing.y);
+
+			TerrainVertex& vertex = row[x - dirtyMin.x];
+			vertex.position = positionAt({x, y}, heightAt({x, y}));
+			vertex.normal = glm::packSnorm3x10_1x2(
+			    glm::vec4(glm::normalize(glm::vec3(-slopeX, 1, -slopeZ)), 0));
+		}
+
+		// one upload per row, of just the dirty columns
+		size_t first = index({dirtyMin.x, y});
+		std::visit([&](auto& mesh) { mesh->updateVerticies(first, row); }, this->mesh);
+		uploaded += row.size();
+	}
+	return uploaded;
 }
@@ -2,65 +2,186 @@
 #define GENTERRAIN_HPP
 
 #include "common.hpp"
+#include "heightfield.hpp"
 #include "mesh.hpp"
+#include "noiseKernel.hpp"
 #include "terrain.hpp"
 
 #include <glm/geometric.hpp>
 #include <glm/gtx/string_cast.hpp>
 
-#include <boost/multi_array.hpp>
-
 #include <PerlinNoise.hpp>
 
 #include <limits>
 #include <memory>
+#include <optional>
+#include <variant>
 
 // contains a diffuse and specular component
-struct DSColor {
-	glm::vec3 diffuse;
-	glm::vec3 specular;
+// defined in terrain.frag.glsl so it can go straight into the terrain material
+typedef Shaders::DSColor DSColor;
+
+// how terrain normals are calculated
+enum class NormalMethod {
+	// samples the noise 4 extra times around each point and averages the quadrants' normals
+	// TODO: fix artifacts in normals with strange X patterns
+	perlinSamples,
+	// central differences over the height grid, which has a 1 sample border so edges work
+	// only evaluates noise once per sample (plus the border)
+	heightGrid,
+	// the noise's analytic gradient, from the same SIMD pass as the heights
+	analytic,
 };
 
-class Terrain : public BaseSceneGraphObject {
+// CPU-side terrain data, ready to be put in a mesh
+struct TerrainGeometry {
+	std::vector<TerrainVertex> verticies;
+	std::vector<uint> indicies;
+};
+
+// a grid's indicies split into ranges that each fit in 16 bits
+struct SplitGridIndicies {
+	std::vector<ushort> indicies;
+	std::vector<DrawRange> ranges;
+};
+
+// Generates terrain geometry. Doesn't touch OpenGL and only reads its own state while generating,
+// so it's safe to use from any thread.
+class TerrainGenerator {
   private:
 	ulong seed;
-	float shininess;
-	DSColor bottomColor;
-	DSColor topColor;
-	Shaders::Terrain shader;
 	glm::vec3 size;
 	glm::uvec2 samples;
+	NormalMethod normalMethod;
 	siv::PerlinNoise noise;
+	NoiseKernel noiseKernel;
 
 	// flatten a 2d coordinate into a 1d index
 	// row major
-	uint flatten(const glm::uvec2 coord, const glm::uvec2 size) {
+	uint flatten(const glm::uvec2 coord, const glm::uvec2 size) const {
 		return coord.y * size.x + coord.x;
 	}
 
-	glm::vec3 pointFromData(const boost::multi_array<float, 2>& data, const glm::uvec2 point,
-	                        const glm::vec3 scale,
-	                        const float fallback = std::numeric_limits<float>::quiet_NaN());
+	// where the sample at coord goes, once it's been given a height
+	glm::vec3 positionAt(const glm::uvec2 coord, const glm::ivec2 offset, const glm::vec3 scale,
+	                     const float height) const {
+		return {(offset.x + (int)coord.x) * scale.x, height, (offset.y + (int)coord.y) * scale.y};
+	}
 
 	// handles scaling
-	glm::vec3 pointAt(const glm::vec2& pos);
+	glm::vec3 pointAt(const glm::vec2& pos) const;
+
+	// Each fills rows [yBegin, yEnd) of verticies, which is row major and samples.x wide, in a
+	// single pass. heights has a 1 sample border, from generateHeights.
+	void perlinSampleRows(TerrainVertex* verticies, const uint yBegin, const uint yEnd,
+	                      const glm::ivec2 offset, const glm::vec3 scale) const;
+	void heightGridRows(TerrainVertex* verticies, const float* heights, const uint yBegin,
+	                    const uint yEnd, const glm::ivec2 offset, const glm::vec3 scale) const;
+	void analyticRows(TerrainVertex* verticies, const uint yBegin, const uint yEnd,
+	                  const glm::ivec2 offset, const glm::vec3 scale) const;
 
   public:
-	Terrain(const ulong& seed, const float& shininess, const DSColor& bottomColor,
-	        const DSColor& topColor, const glm::vec3& size, const glm::uvec2& samples,
-	        const Shaders::Terrain shader)
-	    : BaseSceneGraphObject(glm::mat4(1)) {
+	// Bump whenever a change makes generate() produce different terrain, so the heightfield cache
+	// doesn't hand out terrain from the old version.
+	static constexpr uint version = 1;
+
+	TerrainGenerator(const ulong seed, const glm::vec3& size, const glm::uvec2& samples,
+	                 const NormalMethod normalMethod)
+	    : noise(seed), noiseKernel(noise) {
 		this->seed = seed;
-		this->shininess = shininess;
-		this->bottomColor = bottomColor;
-		this->topColor = topColor;
-		this->shader = shader;
 		this->size = size;
 		this->samples = samples;
-		this->noise = siv::PerlinNoise{seed};
+		this->normalMethod = normalMethod;
+	}
 
-		Mesh<ColorVertex, Shaders::Terrain> terrain = this->getTerrain();
-		this->addChild(std::make_shared<Mesh<ColorVertex, Shaders::Terrain>>(terrain));
+	// how many times generate() evaluates the noise function
+	ulong noiseEvaluations() const;
+
+	// world units between samples, and the height of the tallest possible point
+	glm::vec3 getScale() const {
+		return {this->size.x / this->samples.x, this->size.y / this->samples.y, this->size.z};
+	}
+
+	glm::uvec2 getSamples() const { return this->samples; }
+
+	// Rows are split across up to `threads` threads from the shared pool. The output is identical
+	// no matter how many threads are used.
+	// offset is in samples, so generators with the same settings and offsets a multiple of
+	// samples - 1 apart produce tiles whose edges match exactly.
+	TerrainGeometry generate(const uint threads, const glm::ivec2 offset) const;
+
+	// identifies what generate() makes with these settings, including the version
+	ulong cacheKey(const glm::ivec2 offset) const;
+
+	// Same as generate(), but memory maps the heights and normals from the cache if they're there,
+	// skipping the noise entirely. Otherwise generates them and saves them for next time.
+	TerrainGeometry generateCached(const uint threads, const glm::ivec2 offset) const;
+
+	// Just the heights, row major, with a 1 sample border on every side so normals can be found
+	// at the edges. The same as the heights generate() uses for heightGrid normals.
+	std::vector<float> generateHeights(const uint threads, const glm::ivec2 offset) const;
+
+	// The height of one sample at offset 0, which can be past the grid, like generateHeights'
+	// border. The same as generateHeights gives for it.
+	float sampleHeight(const glm::ivec2 coord) const;
+
+	// two triangles for every square of a row major grid
+	static std::vector<uint> gridIndicies(const glm::uvec2 samples, const uint threads);
+
+	// The same triangles as gridIndicies, in bands of whole rows that each span at most 65536
+	// vertices, so they can use 16 bit indicies from each band's baseVertex. Bands share their
+	// edge row. Each band is reordered for the vertex cache. nullopt if the grid is so wide that
+	// two rows don't fit.
+	static std::optional<SplitGridIndicies> splitGridIndicies(const glm::uvec2 samples,
+	                                                          const uint threads);
+};
+
+// material for terrain with colors blended between bottomColor and topColor by height
+inline Shaders::TerrMaterial makeTerrainMaterial(const float shininess, const DSColor& bottomColor,
+                                                 const DSColor& topColor, const float maxHeight) {
+	return {
+	    .shininess = shininess,
+	    .bottomColor = bottomColor,
+	    .topColor = topColor,
+	    .maxHeight = maxHeight,
+	};
+}
+
+enum class BrushMode { raise, lower, flatten };
+
+// a round brush for editing terrain, strongest in the middle and fading out to its radius
+struct TerrainBrush {
+	BrushMode mode;
+	float radius; // in world units
+	// how far the middle moves for raise and lower
+	// for flatten, how much of the way to height it goes, from 0 to 1
+	float strength;
+	float height; // only used by flatten
+};
+
+class Terrain : public BaseSceneGraphObject {
+  private:
+	typedef Mesh<TerrainVertex, Shaders::Terrain, ushort> ShortMesh;
+	typedef Mesh<TerrainVertex, Shaders::Terrain> WideMesh;
+
+	Shaders::TerrMaterial material;
+	Shaders::Terrain shader;
+	TerrainGenerator generator;
+	std::variant<std::shared_ptr<ShortMesh>, std::shared_ptr<WideMesh>> mesh;
+	Heightfield heightfield; // kept in step with the mesh, for queries
+
+	// 16 bit indicies if the grid allows, which it does unless it's over 32768 samples wide
+	void buildMesh();
+
+  public:
+	Terrain(const ulong& seed, const float& shininess, const DSColor& bottomColor,
+	        const DSColor& topColor, const glm::vec3& size, const glm::uvec2& samples,
+	        const NormalMethod normalMethod, const Shaders::Terrain shader)
+	    : BaseSceneGraphObject(glm::mat4(1)), generator(seed, size, samples, normalMethod) {
+		this->material = makeTerrainMaterial(shininess, bottomColor, topColor, size.z);
+		this->shader = shader;
+
+		this->buildMesh();
 	}
 
 	virtual void render(const Camera& camera [[maybe_unused]],
@@ -70,7 +191,25 @@ class Terrain : public BaseSceneGraphObject {
 		std::println("{}Terrain:", std::string(SCENE_GRAPH_INDENT * cascade.recurseDepth, ' '));
 	}
 
-	Mesh<ColorVertex, Shaders::Terrain> getTerrain();
+	// Edits the heights around center, which is in this node's space along x and z. Only the
+	// samples under the brush and the ring around them, whose normals depend on them, are
+	// recalculated and uploaded, so an edit costs the same however big the terrain is. Normals
+	// there are recalculated with central differences, whatever the normal method. Past the
+	// terrain's edges they use the generator's heights, like heightGrid's border, so with
+	// heightGrid normals an edit that reaches an edge only changes normals whose heights did.
+	// Returns how many verticies were uploaded.
+	uint applyBrush(const glm::vec2& center, const TerrainBrush& brush);
+
+	// queries in this node's space, see Heightfield
+	float heightAt(const glm::vec2& pos) const { return this->heightfield.heightAt(pos); }
+	glm::vec3 normalAt(const glm::vec2& pos) const { return this->heightfield.normalAt(pos); }
+	std::optional<HeightfieldHit>
+	raycast(const glm::vec3& origin, const glm::vec3& direction,
+	        const float maxDistance = std::numeric_limits<float>::infinity()) const {
+		return this->heightfield.raycast(origin, direction, maxDistance);
+	}
+
+	const Heightfield& getHeightfield() const { return this->heightfield; }
 };
 
 #endif /* GENTERRAIN_HPP */
@@ -0,0 +1,73 @@
+#ifndef GLHANDLE_HPP
+#define GLHANDLE_HPP
+
+#include "common.hpp"
+
+#include <glad/gl.h>
+
+#include <utility>
+
+// Owns one GL object, made when the handle is and deleted along with it. Move only, since a
+// copy would delete the object twice. Kind says how to make and delete it.
+template <typename Kind> class GlHandle {
+  private:
+	uint id; // 0 once it's been moved from
+
+	GlHandle(const GlHandle&) = delete;
+	GlHandle& operator=(const GlHandle&) = delete;
+
+  public:
+	GlHandle() { this->id = Kind::create(); }
+
+	GlHandle(GlHandle&& other) noexcept { this->id = std::exchange(other.id, 0); }
+
+	GlHandle& operator=(GlHandle&& other) noexcept {
+		if (this != &other) {
+			if (this->id != 0) Kind::destroy(this->id);
+			this->id = std::exchange(other.id, 0);
+		}
+		return *this;
+	}
+
+	~GlHandle() {
+		if (this->id != 0) Kind::destroy(this->id);
+	}
+
+	uint get() const { return this->id; }
+};
+
+struct GlBufferKind {
+	static uint create() {
+		uint id;
+		glGenBuffers(1, &id);
+		return id;
+	}
+
+	static void destroy(uint id) { glDeleteBuffers(1, &id); }
+};
+
+struct GlVertexArrayKind {
+	static uint create() {
+		uint id;
+		glGenVertexArrays(1, &id);
+		return id;
+	}
+
+	static void destroy(uint id) { glDeleteVertexArrays(1, &id); }
+};
+
+struct GlTextureKind {
+	static uint create() {
+		uint id;
+		glGenTextures(1, &id);
+		return id;
+	}
+
+	static void destroy(uint id) { glDeleteTextures(1, &id); }
+};
+
+typedef GlHandle<GlBufferKind> GlBuffer;
+typedef GlHandle<GlVertexArrayKind> GlVertexArray;
+typedef GlHandle<GlTextureKind> GlTexture;
+
+#endif /* GLHANDLE_HPP */
@@ -0,0 +1,263 @@
+#include "heightfield.hpp"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+Heightfield::Heightfield(const glm::uvec2 samples, const glm::vec2& spacing,
+                         std::vector<float> heights) {
+	if (samples.x < 2 or samples.y < 2)
+		throw std::invalid_argument(
+		    std::format("A {}x{} heightfield doesn't have any cells.", samples.x, samples.y));
+	if (heights.size() != (size_t)samples.x * samples.y)
+		throw std::invalid_argument(std::format("{} heights don't make a {}x{} heightfield.",
+		                                        heights.size(), samples.x, samples.y));
+
+	this->samples = samples;
+	this->spacing = spacing;
+	this->heights = std::move(heights);
+
+	// halve until there's one entry left
+	glm::uvec2 size = samples - 1u;
+	while (true) {
+		this->levelSizes.push_back(size);
+		this->pyramid.emplace_back((size_t)size.x * size.y);
+		if (size == glm::uvec2(1)) break;
+		size = (size + 1u) / 2u;
+	}
+
+	this->updatePyramid({0, 0}, samples - 2u);
+}
+
+void Heightfield::updatePyramid(glm::uvec2 min, glm::uvec2 max) {
+	for (uint y = min.y; y <= max.y; y++) {
+		for (uint x = min.x; x <= max.x; x++) {
+			std::array<float, 4> corners{
+			    this->sample({x, y}),
+			    this->sample({x + 1, y}),
+			    this->sample({x, y + 1}),
+			    this->sample({x + 1, y + 1}),
+			};
+			auto [low, high] = std::minmax_element(ALL_OF(corners));
+			this->bounds(0, {x, y}) = {*low, *high};
+		}
+	}
+
+	for (uint level = 1; level < this->pyramid.size(); level++) {
+		min /= 2u;
+		max /= 2u;
+		const glm::uvec2 childSize = this->levelSizes[level - 1];
+		for (uint y = min.y; y <= max.y; y++) {
+			for (uint x = min.x; x <= max.x; x++) {
+				// up to 2x2 children; the last row and column may only have one
+				Bounds combined = this->bounds(level - 1, {x * 2, y * 2});
+				glm::uvec2 childEnd = glm::min(glm::uvec2(x, y) * 2u + 2u, childSize);
+				for (uint childY = y * 2; childY < childEnd.y; childY++) {
+					for (uint childX = x * 2; childX < childEnd.x; childX++) {
+						const Bounds& child = this->bounds(level - 1, {childX, childY});
+						combined.min = std::min(combined.min, child.min);
+						combined.max = std::max(combined.max, child.max);
+					}
+				}
+				this->bounds(level, {x, y}) = combined;
+			}
+		}
+	}
+}
+
+void Heightfield::setHeights(const glm::uvec2 corner, const glm::uvec2 extent,
+                             const float* heights) {
+	if (extent.x == 0 or extent.y == 0) return;
+	if (corner.x + extent.x > this->samples.x or corner.y + extent.y > this->samples.y)
+		throw std::out_of_range(std::format("Height edit at ({}, {}) of size {}x{} is off the "
+		                                    "heightfield.",
+		                                    corner.x, corner.y, extent.x, extent.y));
+
+	for (uint y = 0; y < extent.y; y++) {
+		std::copy_n(heights + y * extent.x, extent.x,
+		            this->heights.begin() + (corner.y + y) * this->samples.x + corner.x);
+	}
+
+	// every cell that has one of the edited samples as a corner
+	glm::uvec2 cellsMin = glm::uvec2(glm::max(glm::ivec2(corner) - 1, 0));
+	glm::uvec2 cellsMax = glm::min(corner + extent - 1u, this->samples - 2u);
+	this->updatePyramid(cellsMin, cellsMax);
+}
+
+glm::uvec2 Heightfield::cellAt(const glm::vec2& pos, glm::vec2& fraction) const {
+	glm::vec2 grid =
+	    glm::clamp(pos / this->spacing, glm::vec2(0), glm::vec2(this->samples - 1u));
+	// the far edge belongs to the last cell
+	glm::uvec2 cell = glm::min(glm::uvec2(grid), this->samples - 2u);
+	fraction = grid - glm::vec2(cell);
+	return cell;
+}
+
+float Heightfield::heightAt(const glm::vec2& pos) const {
+	glm::vec2 fraction;
+	glm::uvec2 cell = this->cellAt(pos, fraction);
+	float bottom =
+	    glm::mix(this->sample(cell), this->sample(cell + glm::uvec2(1, 0)), fraction.x);
+	float top =
+	    glm::mix(this->sample(cell + glm::uvec2(0, 1)), this->sample(cell + 1u), fraction.x);
+	return glm::mix(bottom, top, fraction.y);
+}
+
+glm::vec3 Heightfield::normalAt(const glm::vec2& pos) const {
+	glm::vec2 fraction;
+	glm::uvec2 cell = this->cellAt(pos, fraction);
+	float h00 = this->sample(cell);
+	float h10 = this->sample(cell + glm::uvec2(1, 0));
+	float h01 = this->sample(cell + glm::uvec2(0, 1));
+	float h11 = this->sample(cell + 1u);
+
+	// derivatives of the bilinear patch
+	float slopeX = glm::mix(h10 - h00, h11 - h01, fraction.y) / this->spacing.x;
+	float slopeZ = glm::mix(h01 - h00, h11 - h10, fraction.x) / this->spacing.y;
+	return glm::normalize(glm::vec3(-slopeX, 1, -slopeZ));
+}
+
+std::optional<float> Heightfield::intersectCell(const glm::uvec2 cell, const glm::vec3& origin,
+                                                const glm::vec3& direction, const float tMin,
+                                                const float tMax) const {
+	// h(u, v) = a + b * u + c * v + e * u * v, with u and v from 0 to 1 across the cell
+	float a = this->sample(cell);
+	float b = this->sample(cell + glm::uvec2(1, 0)) - a;
+	float c = this->sample(cell + glm::uvec2(0, 1)) - a;
+	float e = this->sample(cell + 1u) - a - b - c;
+
+	// the ray from tMin, as s goes from 0 to tMax - tMin
+	glm::vec3 start = origin + tMin * direction;
+	float u = start.x - cell.x;
+	float v = start.z - cell.y;
+
+	// height above the surface, as a quadratic in s
+	float constant = start.y - (a + b * u + c * v + e * u * v);
+	if (constant <= 0) return tMin;
+	float linear = direction.y - b * direction.x - c * direction.z
+	             - e * (u * direction.z + v * direction.x);
+	float quadratic = -e * direction.x * direction.z;
+
+	const float sMax = tMax - tMin;
+	// the first s in range where the height crosses 0
+	float s = std::numeric_limits<float>::infinity();
+	if (std::abs(quadratic) < 1e-12f) {
+		if (linear < 0) s = -constant / linear;
+	} else {
+		float discriminant = linear * linear - 4 * quadratic * constant;
+		if (discriminant < 0) return std::nullopt;
+		float root = std::sqrt(discriminant);
+		float s0 = (-linear - root) / (2 * quadratic);
+		float s1 = (-linear + root) / (2 * quadratic);
+		if (s0 > s1) std::swap(s0, s1);
+		if (s0 >= 0) s = s0;
+		else if (s1 >= 0) s = s1;
+	}
+
+	if (s > sMax) return std::nullopt;
+	return tMin + s;
+}
+
+// Clips [tMin, tMax] to where origin + t * direction is between low and high along one axis.
+// Returns false if nothing is left.
+static bool clipSlab(const float origin, const float direction, const float low, const float high,
+                     float& tMin, float& tMax) {
+	if (direction == 0) return origin >= low and origin <= high;
+	float t0 = (low - origin) / direction;
+	float t1 = (high - origin) / direction;
+	if (t0 > t1) std::swap(t0, t1);
+	tMin = std::max(tMin, t0);
+	tMax = std::min(tMax, t1);
+	return tMin <= tMax;
+}
+
+std::optional<HeightfieldHit> Heightfield::raycast(const glm::vec3& origin,
+                                                   const glm::vec3& direction,
+                                                   const float maxDistance) const {
+	float length = glm::length(direction);
+	if (length == 0) return std::nullopt;
+
+	// in samples along x and z, but world units for y
+	// t is the same in both spaces, so only the final hit needs converting back
+	glm::vec3 gridOrigin{origin.x / this->spacing.x, origin.y, origin.z / this->spacing.y};
+	glm::vec3 gridDirection{direction.x / this->spacing.x, direction.y,
+	                        direction.z / this->spacing.y};
+	glm::vec2 gridMax{this->samples - 1u};
+
+	auto makeHit = [&](const float t) {
+		glm::vec3 position = origin + t * direction;
+		return HeightfieldHit{
+		    .position = position,
+		    .normal = this->normalAt({position.x, position.z}),
+		    .distance = t * length,
+		};
+	};
+
+	float tMin = 0;
+	float tMax = maxDistance / length;
+	const Bounds& everything = this->pyramid.back()[0];
+	if (not clipSlab(gridOrigin.x, gridDirection.x, 0, gridMax.x, tMin, tMax)
+	    or not clipSlab(gridOrigin.z, gridDirection.z, 0, gridMax.y, tMin, tMax)
+	    or not clipSlab(gridOrigin.y, gridDirection.y, -std::numeric_limits<float>::infinity(),
+	                    everything.max, tMin, tMax))
+		return std::nullopt;
+
+	// how far t has to move to get a sliver past a cell's edge, so the next cell is picked
+	float horizontal = std::max(std::abs(gridDirection.x), std::abs(gridDirection.z));
+	const float nudge = horizontal > 0 ? 1e-4f / horizontal : tMax;
+
+	const uint top = this->pyramid.size() - 1;
+	uint level = top;
+	float t = tMin;
+	while (t <= tMax) {
+		glm::vec3 position = gridOrigin + t * gridDirection;
+		const uint cellSize = 1u << level;
+		glm::vec2 scaled = glm::clamp(glm::vec2(position.x, position.z) / (float)cellSize,
+		                              glm::vec2(0), glm::vec2(this->levelSizes[level] - 1u));
+		glm::uvec2 cell{scaled};
+
+		// where the ray leaves this cell
+		glm::vec2 low = glm::vec2(cell * cellSize);
+		glm::vec2 high = glm::min(low + (float)cellSize, gridMax);
+		float cellEnter = t;
+		float cellExit = tMax;
+		clipSlab(gridOrigin.x, gridDirection.x, low.x, high.x, cellEnter, cellExit);
+		clipSlab(gridOrigin.z, gridDirection.z, low.y, high.y, cellEnter, cellExit);
+		cellExit = std::max(cellExit, t);
+
+		// the ray is straight, so its lowest point across the cell is at one of the ends
+		float startY = gridOrigin.y + t * gridDirection.y;
+		float endY = gridOrigin.y + cellExit * gridDirection.y;
+		const Bounds& bounds = this->bounds(level, cell);
+		// already under every part of the cell, so it's in the ground
+		if (startY <= bounds.min) return makeHit(t);
+		if (std::min(startY, endY) <= bounds.max) {
+			if (level > 0) {
+				// might hit something in here, so look closer
+				level--;
+				continue;
+			}
+			std::optional<float> hit =
+			    this->intersectCell(cell, gridOrigin, gridDirection, t, cellExit);
+			if (hit.has_value()) return makeHit(*hit);
+		}
+
+		// nothing in this cell, so move past it and look at the bigger picture again
+		t = cellExit + nudge;
+		if (level < top) level++;
+	}
+
+	return std::nullopt;
+}
+
+size_t Heightfield::sizeBytes() const {
+	size_t bytes = VECTOR_SIZE_BYTES(this->heights);
+	for (const std::vector<Bounds>& level : this->pyramid) bytes += level.size() * sizeof(Bounds);
+	return bytes;
+}
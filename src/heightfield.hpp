@@ -0,0 +1,101 @@
+#ifndef HEIGHTFIELD_HPP
+#define HEIGHTFIELD_HPP
+
+#include "common.hpp"
+
+#include <glm/ext/vector_float2.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_int2.hpp>
+#include <glm/ext/vector_uint2.hpp>
+
+#include <limits>
+#include <optional>
+#include <vector>
+
+// where a ray hit a heightfield
+struct HeightfieldHit {
+	glm::vec3 position;
+	glm::vec3 normal;
+	float distance; // along the ray, in world units
+};
+
+// A grid of heights for answering queries about terrain without touching its mesh. Sample (x, y)
+// is at (x * spacing.x, height, y * spacing.y), and the surface between samples is bilinear.
+// Raycasts walk a min-max pyramid over the cells, so they skip over whole regions the ray passes
+// above or below, taking roughly O(log n) steps instead of visiting every cell along the way.
+class Heightfield {
+  private:
+	// the lowest and highest height in a block of cells
+	struct Bounds {
+		float min;
+		float max;
+	};
+
+	glm::uvec2 samples;
+	glm::vec2 spacing;
+	std::vector<float> heights; // row major
+
+	// Level 0 has one entry per cell, each level above covers 2x2 of the one below. The last level
+	// is a single entry covering everything.
+	std::vector<std::vector<Bounds>> pyramid;
+	std::vector<glm::uvec2> levelSizes;
+
+	float sample(const glm::uvec2 coord) const {
+		return this->heights[coord.y * this->samples.x + coord.x];
+	}
+
+	Bounds& bounds(const uint level, const glm::uvec2 cell) {
+		return this->pyramid[level][cell.y * this->levelSizes[level].x + cell.x];
+	}
+
+	const Bounds& bounds(const uint level, const glm::uvec2 cell) const {
+		return this->pyramid[level][cell.y * this->levelSizes[level].x + cell.x];
+	}
+
+	// recalculates the pyramid over cells [min, max] of level 0, and every level above them
+	void updatePyramid(glm::uvec2 min, glm::uvec2 max);
+
+	// the cell containing pos, in samples, and how far across it pos is, from 0 to 1
+	// positions off the grid are clamped to its edge
+	glm::uvec2 cellAt(const glm::vec2& pos, glm::vec2& fraction) const;
+
+	// Where a ray in sample space hits the bilinear patch over cell between tMin and tMax, or
+	// nullopt if it doesn't.
+	std::optional<float> intersectCell(const glm::uvec2 cell, const glm::vec3& origin,
+	                                   const glm::vec3& direction, const float tMin,
+	                                   const float tMax) const;
+
+  public:
+	Heightfield() = default;
+
+	// heights is row major, samples.x * samples.y long, and there must be at least 2 samples
+	// along each side
+	Heightfield(const glm::uvec2 samples, const glm::vec2& spacing, std::vector<float> heights);
+
+	// Replaces the heights in a rectangle starting at corner. heights is row major and extent.x
+	// wide. Only the pyramid above the rectangle is rebuilt.
+	void setHeights(const glm::uvec2 corner, const glm::uvec2 extent, const float* heights);
+
+	// positions are along x and z, and are clamped to the edge of the heightfield
+	float heightAt(const glm::vec2& pos) const;
+	glm::vec3 normalAt(const glm::vec2& pos) const;
+
+	// The first place a ray hits the surface, if it does within maxDistance. direction doesn't
+	// need to be normalized. Everything under the surface counts as solid, so a ray that starts
+	// under it, or comes in through the side under it, hits where it starts or comes in.
+	std::optional<HeightfieldHit>
+	raycast(const glm::vec3& origin, const glm::vec3& direction,
+	        const float maxDistance = std::numeric_limits<float>::infinity()) const;
+
+	// the height of one sample, without any interpolation
+	float getHeight(const glm::uvec2 coord) const { return this->sample(coord); }
+
+	glm::uvec2 getSamples() const { return this->samples; }
+
+	glm::vec2 getSpacing() const { return this->spacing; }
+
+	// bytes used by the heights and pyramid
+	size_t sizeBytes() const;
+};
+
+#endif /* HEIGHTFIELD_HPP */
@@ -0,0 +1,105 @@
+#include "heightmapTerrain.hpp"
+
+#include "threadPool.hpp"
+
+#include <glad/gl.h>
+
+#include <glm/matrix.hpp>
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+HeightmapTerrain::HeightmapTerrain(const ulong seed, const float shininess,
+                                   const DSColor& bottomColor, const DSColor& topColor,
+                                   const glm::vec3& size, const glm::uvec2& samples,
+                                   const Shaders::Terrain shader)
+    : BaseSceneGraphObject(glm::mat4(1)) {
+	this->material = makeTerrainMaterial(shininess, bottomColor, topColor, size.z);
+	this->shader = shader;
+	this->samples = samples;
+
+	TerrainGenerator generator{seed, size, samples, NormalMethod::heightGrid};
+	this->spacing = glm::vec2(generator.getScale());
+	this->heights = generator.generateHeights(defaultThreadCount(), {0, 0});
+
+	glBindTexture(GL_TEXTURE_2D, this->texture.get());
+	// only read with texelFetch, so there's no filtering or mipmaps
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, samples.x + 2, samples.y + 2, 0, GL_RED, GL_FLOAT,
+	             this->heights.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// no attributes, but drawing still needs a VAO to hold the index buffer
+	std::optional<SplitGridIndicies> indicies =
+	    TerrainGenerator::splitGridIndicies(samples, defaultThreadCount());
+	if (not indicies.has_value())
+		throw std::invalid_argument(std::format(
+		    "Heightmap terrain can't be {} samples wide, the limit is 32768.", samples.x));
+	this->ranges = std::move(indicies->ranges);
+	this->indexCount = indicies->indicies.size();
+	glBindVertexArray(this->VAO.get());
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO.get());
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, VECTOR_SIZE_BYTES(indicies->indicies),
+	             indicies->indicies.data(), GL_STATIC_DRAW);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void HeightmapTerrain::setHeights(const glm::ivec2 corner, const glm::uvec2 extent,
+                                  const float* heights) {
+	// in texels, which start at the border
+	glm::ivec2 start = corner + 1;
+	glm::ivec2 end = start + glm::ivec2(extent);
+	if (start.x < 0 or start.y < 0 or end.x > (int)this->samples.x + 2
+	    or end.y > (int)this->samples.y + 2)
+		throw std::out_of_range(std::format("Height edit at ({}, {}) of size {}x{} is off the "
+		                                    "terrain.",
+		                                    corner.x, corner.y, extent.x, extent.y));
+
+	for (uint y = 0; y < extent.y; y++) {
+		std::copy_n(heights + y * extent.x, extent.x,
+		            this->heights.begin() + this->flatten(glm::uvec2(start.x, start.y + y)));
+	}
+
+	// only the edited rectangle is uploaded
+	glBindTexture(GL_TEXTURE_2D, this->texture.get());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, start.x, start.y, extent.x, extent.y, GL_RED, GL_FLOAT,
+	                heights);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void HeightmapTerrain::render(const Camera& camera, const SceneCascade& cascade) {
+	SceneCascade combinedCascade = cascade + this->getNodeCascade();
+
+	this->shader->use();
+	this->shader->setObj2world(combinedCascade.transform);
+	this->shader->setObj2normal(glm::mat3(glm::transpose(glm::inverse(combinedCascade.transform))));
+	this->shader->setWorld2cam(camera.toCamSpace());
+	this->shader->setProjection(camera.projectionMat());
+	this->shader->setViewPos(camera.getPosition());
+	this->shader->setMaterial(this->material);
+
+	this->shader->setHeightmapEnabled(true);
+	this->shader->setHeightmap(0);
+	this->shader->setHeightmapSamples(glm::ivec2(this->samples));
+	this->shader->setHeightmapSpacing(this->spacing);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, this->texture.get());
+	glBindVertexArray(this->VAO.get());
+	for (const DrawRange& range : this->ranges) {
+		glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_SHORT,
+		                         (void*)(range.firstIndex * sizeof(ushort)), range.baseVertex);
+	}
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// the shader is shared with terrain that has vertex attributes
+	this->shader->setHeightmapEnabled(false);
+	this->shader->stopUsing();
+}
@@ -0,0 +1,76 @@
+#ifndef HEIGHTMAPTERRAIN_HPP
+#define HEIGHTMAPTERRAIN_HPP
+
+#include "camera.hpp"
+#include "common.hpp"
+#include "genTerrain.hpp"
+#include "glHandle.hpp"
+#include "sceneObject.hpp"
+#include "terrain.hpp"
+
+#include <glm/ext/vector_float2.hpp>
+#include <glm/ext/vector_uint2.hpp>
+
+#include <vector>
+
+// Terrain that only uploads its heights, as a texture. There aren't any vertex attributes:
+// terrain.vert.glsl rebuilds each vertex's position from gl_VertexID, and its normal from the
+// heights around it. Owns its texture, VAO and index buffer, so it's move only.
+class HeightmapTerrain : public BaseSceneGraphObject {
+  private:
+	Shaders::TerrMaterial material;
+	Shaders::Terrain shader;
+	glm::vec2 spacing; // between samples
+	glm::uvec2 samples;
+
+	// includes a 1 sample border, so (samples + 2) wide
+	std::vector<float> heights;
+	GlTexture texture;
+	// 16 bit, in bands of rows drawn from their own base vertex, which gl_VertexID includes
+	GlVertexArray VAO;
+	GlBuffer EBO;
+	std::vector<DrawRange> ranges;
+	uint indexCount;
+
+	uint flatten(const glm::uvec2 coord) const { return coord.y * (this->samples.x + 2) + coord.x; }
+
+	HeightmapTerrain(const HeightmapTerrain&) = delete;
+	HeightmapTerrain& operator=(const HeightmapTerrain&) = delete;
+
+  public:
+	// normals always come from central differences of the heights, like NormalMethod::heightGrid
+	HeightmapTerrain(const ulong seed, const float shininess, const DSColor& bottomColor,
+	                 const DSColor& topColor, const glm::vec3& size, const glm::uvec2& samples,
+	                 const Shaders::Terrain shader);
+
+	virtual void render(const Camera& camera, const SceneCascade& cascade);
+
+	HeightmapTerrain(HeightmapTerrain&&) = default;
+	HeightmapTerrain& operator=(HeightmapTerrain&&) = default;
+
+	virtual void print(const SceneCascade& cascade) {
+		float vertexCount = this->samples.x * this->samples.y;
+		std::println("{}HeightmapTerrain: {} bytes of heights and {} of indicies per vertex",
+		             std::string(SCENE_GRAPH_INDENT * cascade.recurseDepth, ' '),
+		             VECTOR_SIZE_BYTES(this->heights) / vertexCount,
+		             this->indexCount * sizeof(ushort) / vertexCount);
+	}
+
+	// Replaces the heights in a rectangle starting at corner, only uploading those rows. heights
+	// is row major and extent.x wide. corner can be -1 or extent can reach samples to edit the
+	// border, which the normals along the edges depend on.
+	void setHeights(const glm::ivec2 corner, const glm::uvec2 extent, const float* heights);
+
+	float getHeight(const glm::uvec2 coord) const {
+		return this->heights[this->flatten(coord + 1u)];
+	}
+
+	// bytes of texture and index data uploaded to the GPU
+	size_t gpuBytes() const {
+		return VECTOR_SIZE_BYTES(this->heights) + this->indexCount * sizeof(ushort);
+	}
+
+	virtual ~HeightmapTerrain() = default;
+};
+
+#endif /* HEIGHTMAPTERRAIN_HPP */
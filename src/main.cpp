@@ -1,15 +1,21 @@
+#include "benchmarks.hpp"
 #include "camera.hpp"
 #include "common.hpp"
+#include "diskCache.hpp"
 #include "genTerrain.hpp"
 #include "imguiConfig.hpp"
 #include "lightCube.hpp"
 #include "lighting.hpp"
+#include "mipChain.hpp"
 #include "model.hpp"
 #include "object.hpp"
+#include "resourceManager.hpp"
 #include "sceneConf.hpp"
 #include "sdlConfig.hpp"
 #include "shaders.hpp"
+#include "startupReport.hpp"
 #include "terrain.hpp"
+#include "textureStreamer.hpp"
 #include "vertexData.hpp"
 
 #include <glad/gl.h>
@@ -33,14 +39,39 @@
 #include <string>
 
 int main(int argc, char** argv) {
+	// the report's times start here
+	StartupReport::Phase startup = getStartupReport().begin("startup");
 	std::shared_ptr<Config> conf = parseArgs(argc, argv);
 	if (conf == NULL) return 0;
+	if (conf->useCache) setCacheDir(CACHE_DIR);
+
+	// BENCHMARKS
+
+	const Benchmark* benchmark = NULL;
+	if (conf->benchmark.has_value()) benchmark = &getBenchmarks().at(*conf->benchmark);
+	if (benchmark and not benchmark->needsGL) {
+		benchmark->run();
+		return 0;
+	}
 
 	// SDL
 
 	SDLData sdl;
 	sdl.setup({800, 600});
 
+	getResources().setBudget((size_t)conf->gpuBudgetMiB * 1024 * 1024);
+	getTextureStreamer().setBudget((size_t)conf->textureUploadMiB * 1024 * 1024);
+	if (conf->compressTextures) {
+		if (textureCompressionSupported()) setTextureCompression(true);
+		else std::println("S3TC isn't supported, so textures won't be compressed.");
+	}
+
+	if (benchmark) {
+		benchmark->run();
+		sdl.destroy();
+		return 0;
+	}
+
 	// PERSPECTIVE
 
 	glEnable(GL_CULL_FACE);
@@ -83,12 +114,17 @@ int main(int argc, char** argv) {
 
 	std::print("Compiling shaders... ");
 	std::fflush(stdout);
+	StartupReport::Phase shaderPhase = getStartupReport().begin("shaders");
 	ShaderContainer shaders{
 	    .objShader = Shaders::ObjectImpl::make(),
 	    .terrainShader = Shaders::TerrainImpl::make(),
 	    .lightShader = Shaders::LightCubeImpl::make(),
 	};
-	std::println("Done.");
+	// GL 3.3 can't say how big a program is, so they're only counted
+	getResources().add(ResourceKind::program, "object", shaders.objShader, 0);
+	getResources().add(ResourceKind::program, "terrain", shaders.terrainShader, 0);
+	getResources().add(ResourceKind::program, "lightCube", shaders.lightShader, 0);
+	std::println("Done in {:.3f}s.", shaderPhase.end());
 
 	// SCENE
 	auto scene = initScene(shaders, *conf);
@@ -119,7 +155,9 @@ int main(int argc, char** argv) {
 	// TODO: finish
 
 	// IMGUI
-	makeImGuiContext(sdl.context, sdl.window);
+	getStartupReport().time("imgui init", "",
+	                        [&] { makeImGuiContext(sdl.context, sdl.window); });
+	startup.end();
 
 	// RENDER LOOP
 
@@ -132,6 +170,14 @@ int main(int argc, char** argv) {
 	bool showWireframe = false;
 	bool displayNormals = false;
 
+	// models are still loading, so the report waits until they're done
+	bool startupReported = false;
+	auto reportStartup = [&] {
+		getStartupReport().stop();
+		if (conf->startupReport.has_value()) getStartupReport().write(*conf->startupReport);
+		startupReported = true;
+	};
+
 	bool exit = false;
 	bool resized = true; // populate the perspective matrix
 	float lastFrameTime = 0; // measured since init
@@ -233,15 +279,29 @@ int main(int argc, char** argv) {
 		}
 		visualizeDirLight(dirLight, shaders.lightShader, camera, lightVAO);
 
+		// frees whatever's gone unused if there's too much
+		getResources().endFrame();
+		getTextureStreamer().update();
+
+		if (not startupReported and getStartupReport().isComplete()) reportStartup();
+
 		lastFrameTime = secsSinceInit;
 		imguiRender();
 		SDL_GL_SwapWindow(sdl.window);
 		SDL_Delay(1'000 / 60);
 	}
 
+	// with whatever's still loading as unfinished
+	if (not startupReported) reportStartup();
+
 	glDeleteVertexArrays(1, &lightVAO);
 	glDeleteBuffers(1, &lightVBO);
 
+	// everything has to go while the context is still around
+	scene = nullptr;
+	getTextureStreamer().clear();
+	getResources().clear();
+
 	cleanupImGuiContext();
 	sdl.destroy();
 
@@ -5,23 +5,91 @@
 #include "shaderStructs.hpp"
 #include "terrain.hpp"
 
-template <typename Vertex, Shaders::Shader Shader> void Mesh<Vertex, Shader>::setupMesh() {
-	glGenVertexArrays(1, &this->VAO);
-	glGenBuffers(1, &this->VBO);
-	glGenBuffers(1, &this->EBO);
-	glBindVertexArray(this->VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-	glBufferData(GL_ARRAY_BUFFER, VECTOR_SIZE_BYTES(this->verticies), this->verticies.data(),
-	             GL_STATIC_DRAW);
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, VECTOR_SIZE_BYTES(this->indicies), this->indicies.data(),
-	             GL_STATIC_DRAW);
-
-	STRUCT_MEMBER_ATTRIB(0, Vertex, position);
-	STRUCT_MEMBER_ATTRIB(1, Vertex, normal);
-	if constexpr (requires { Vertex::texCoords; }) {
+#include <algorithm>
+#include <format>
+#include <limits>
+#include <stdexcept>
+
+uint selectLod(const std::span<const MeshLod> lods, const uint current, const MeshBounds& bounds,
+               const Camera& camera, const glm::mat4& transform) {
+	// the bounding sphere in world space, scaled by the transform's biggest axis
+	glm::vec3 center = transform * glm::vec4(bounds.center, 1);
+	float scale = transformScale(transform);
+	// The closest the mesh can be to the camera. Inside the sphere, any error could be right in
+	// front of it.
+	float distance = glm::distance(center, camera.getPosition()) - bounds.radius * scale;
+	if (distance <= 0) return 0;
+
+	// how many pixels one unit of error in the mesh covers, at worst
+	float pixelsPerUnit =
+	    camera.projectionMat()[1][1] * camera.getWindowSize().y / 2 * scale / distance;
+	auto pixelError = [&](const uint lod) { return lods[lod].error * pixelsPerUnit; };
+
+	uint lod = current;
+	while (lod > 0 and pixelError(lod) > lodPixelError) lod--;
+	while (lod + 1 < lods.size() and pixelError(lod + 1) * lodHysteresis < lodPixelError) lod++;
+	return lod;
+}
+
+void bindTextures(const Shaders::Object& shader, const std::span<const Texture> textures) {
+	using Uniform = Shaders::ObjectImpl::Uniform;
+	// the shader only samples the first texture of each type; the rest are bound but unused
+	bool diffuseSet = false;
+	bool specularSet = false;
+
+	// loop through textures and set uniforms
+	for (uint i = 0; i < textures.size(); i++) {
+		glActiveTexture(GL_TEXTURE0 + i);
+		TextureType texType = textures[i].type;
+		if (texType == TextureType::textureDiffuse and not diffuseSet) {
+			shader->setUniform(Uniform::material_textureDiffuse1, (int)i);
+			diffuseSet = true;
+		} else if (texType == TextureType::textureSpecular and not specularSet) {
+			shader->setUniform(Uniform::material_textureSpecular1, (int)i);
+			specularSet = true;
+		}
+		glBindTexture(GL_TEXTURE_2D, textures[i].handle->getId());
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
+
+template <typename Vertex, Shaders::Shader Shader, typename Index>
+void Mesh<Vertex, Shader, Index>::setupMesh(const std::span<const Vertex> verticies,
+                                            const std::span<const Index> indicies) {
+	this->vertexCount = verticies.size();
+	this->indexCount = indicies.size();
+	this->ranges = {{(uint)indicies.size(), 0, 0}};
+	this->lod = {};
+	this->dequantize = glm::mat4(1);
+
+	glBindVertexArray(this->VAO.get());
+
+	glBindBuffer(GL_ARRAY_BUFFER, this->VBO.get());
+	glBufferData(GL_ARRAY_BUFFER, verticies.size_bytes(), verticies.data(), GL_STATIC_DRAW);
+
+	if (this->sharedEBO) {
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->sharedEBO->get());
+	} else {
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO.get());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicies.size_bytes(), indicies.data(),
+		             GL_STATIC_DRAW);
+	}
+
+	if constexpr (std::is_same_v<Vertex, PackedTexVertex>) {
+		STRUCT_MEMBER_ATTRIB_NORMALIZED(0, Vertex, position, 3, GL_SHORT);
+	} else {
+		STRUCT_MEMBER_ATTRIB(0, Vertex, position);
+	}
+	if constexpr (std::is_same_v<Vertex, TerrainVertex>
+	              or std::is_same_v<Vertex, PackedTexVertex>) {
+		STRUCT_MEMBER_ATTRIB_PACKED_NORMAL(1, Vertex, normal);
+	} else {
+		STRUCT_MEMBER_ATTRIB(1, Vertex, normal);
+	}
+
+	if constexpr (std::is_same_v<Vertex, PackedTexVertex>) {
+		STRUCT_MEMBER_ATTRIB_HALF(2, Vertex, texCoords, 2);
+	} else if constexpr (requires { Vertex::texCoords; }) {
 		STRUCT_MEMBER_ATTRIB(2, Vertex, texCoords);
 	} else if constexpr (requires {
 		                     Vertex::diffuse;
@@ -29,6 +97,8 @@ template <typename Vertex, Shaders::Shader Shader> void Mesh<Vertex, Shader>::se
 	                     }) {
 		STRUCT_MEMBER_ATTRIB(2, Vertex, diffuse);
 		STRUCT_MEMBER_ATTRIB(3, Vertex, specular);
+	} else if constexpr (std::is_same_v<Vertex, TerrainVertex>) {
+		// colors come from the material
 	} else {
 		static_assert(false);
 	}
@@ -38,79 +108,102 @@ template <typename Vertex, Shaders::Shader Shader> void Mesh<Vertex, Shader>::se
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
-template <typename Vertex, Shaders::Shader Shader>
-void Mesh<Vertex, Shader>::render(const Camera& camera, const SceneCascade& cascade) {
+template <typename Vertex, Shaders::Shader Shader, typename Index>
+void Mesh<Vertex, Shader, Index>::render(const Camera& camera, const SceneCascade& cascade,
+                                         LodSelection& lod) {
 	// also include this node
 	SceneCascade combinedCascade = cascade + this->getNodeCascade();
+	// the whole mesh, or just the level of detail this instance picked
+	std::span<const DrawRange> ranges = this->ranges;
+	DrawRange lodRange;
+	if (not this->lods.empty()) {
+		lod.resize(1, 0);
+		lod[0] = selectLod(this->lods, lod[0], this->bounds, camera, combinedCascade.transform);
+		lodRange = {this->lods[lod[0]].indexCount, this->lods[lod[0]].firstIndex, 0};
+		ranges = {&lodRange, 1};
+	}
 
+	// the normals weren't quantized, so only the positions go through dequantize
+	glm::mat4 obj2world = combinedCascade.transform * this->dequantize;
 	this->shader->use();
-	this->shader->setUniform("obj2world", combinedCascade.transform);
-	this->shader->setUniform("obj2normal",
-	                         glm::mat3(glm::transpose(glm::inverse(combinedCascade.transform))));
-	this->shader->setUniform("world2cam", camera.toCamSpace());
-	this->shader->setUniform("projection", camera.projectionMat());
-	this->shader->setUniform("viewPos", camera.getPosition());
+	this->shader->setObj2world(obj2world);
+	this->shader->setObj2normal(glm::mat3(glm::transpose(glm::inverse(combinedCascade.transform))));
+	this->shader->setWorld2cam(camera.toCamSpace());
+	this->shader->setProjection(camera.projectionMat());
+	this->shader->setViewPos(camera.getPosition());
 
-	this->draw();
+	this->drawRanges(ranges);
 
 	this->shader->stopUsing();
 }
 
-template <typename Vertex, Shaders::Shader Shader> void Mesh<Vertex, Shader>::draw() {
-	if constexpr (requires { Vertex::texCoords; }) {
-		// counters for number of diffuse/specular textures processed
-		uint diffuseN = 1;
-		uint specularN = 1;
-
-		// loop through textures and set uniforms
-		for (uint i = 0; i < textures.size(); i++) {
-			glActiveTexture(GL_TEXTURE0 + i);
-			std::string number; // texture to use
-			TextureType texType = textures[i].type;
-			if (texType == TextureType::textureDiffuse) number = std::to_string(diffuseN++);
-			else if (texType == TextureType::textureSpecular) number = std::to_string(specularN++);
-
-			this->shader->setUniform(
-			    "material." + std::string(magic_enum::enum_name(texType)) + number, (int)i);
-			glBindTexture(GL_TEXTURE_2D, textures[i].id);
-		}
-		glActiveTexture(GL_TEXTURE0);
-	}
+template <typename Vertex, Shaders::Shader Shader, typename Index>
+void Mesh<Vertex, Shader, Index>::drawRanges(const std::span<const DrawRange> ranges) {
+	if constexpr (requires { Vertex::texCoords; }) bindTextures(this->shader, this->textures);
 
-	this->shader->setUniform("material.shininess", this->shininess);
+	if constexpr (std::is_same_v<Vertex, TerrainVertex>) {
+		this->shader->setMaterial(this->terrainMaterial);
+	} else {
+		this->shader->setUniform(Shaders::ObjectImpl::Uniform::material_shininess,
+		                         this->shininess);
+	}
 
 	// actually draw mesh
-	glBindVertexArray(this->VAO);
-	glDrawElements(GL_TRIANGLES, (uint)this->indicies.size(), GL_UNSIGNED_INT, 0);
+	glBindVertexArray(this->VAO.get());
+	constexpr GLenum indexType =
+	    std::is_same_v<Index, ushort> ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	for (const DrawRange& range : ranges) {
+		glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, indexType,
+		                         (void*)(range.firstIndex * sizeof(Index)), range.baseVertex);
+	}
 	glBindVertexArray(0);
 }
 
-uint loadTexture(const filesystem::path& path) {
-	stbi_set_flip_vertically_on_load(true);
-
-	int width;
-	int height;
-	int nChannels;
-	uchar* data = stbi_load(path.string().c_str(), &width, &height, &nChannels, 0);
+template <typename Vertex, Shaders::Shader Shader, typename Index>
+void Mesh<Vertex, Shader, Index>::updateVerticies(const size_t first,
+                                                  const std::span<const Vertex> verticies) {
+	if (first + verticies.size() > this->vertexCount)
+		throw std::out_of_range(std::format("Can't update verticies {} to {} of a mesh with {}.",
+		                                    first, first + verticies.size(), this->vertexCount));
+
+	if (not this->verticies.empty()) std::copy(ALL_OF(verticies), this->verticies.begin() + first);
+	glBindBuffer(GL_ARRAY_BUFFER, this->VBO.get());
+	glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(Vertex), verticies.size_bytes(),
+	                verticies.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-	if (not data) {
-		throw std::runtime_error(std::format("Error loading image at {}.", path.string()));
+PackedTexVerticies packTexVerticies(const std::span<const TexVertex> verticies) {
+	glm::vec3 low{std::numeric_limits<float>::max()};
+	glm::vec3 high{std::numeric_limits<float>::lowest()};
+	for (const TexVertex& vertex : verticies) {
+		low = glm::min(low, vertex.position);
+		high = glm::max(high, vertex.position);
 	}
-
-	uint texture;
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, nChannels == 3 ? GL_RGB : GL_RGBA,
-	             GL_UNSIGNED_BYTE, data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-	stbi_image_free(data);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	return texture;
+	glm::vec3 center = (low + high) / 2.f;
+	// a flat mesh still needs something to divide by
+	glm::vec3 halfSize = glm::max((high - low) / 2.f, glm::vec3(std::numeric_limits<float>::min()));
+
+	PackedTexVerticies packed{};
+	packed.dequantize = glm::scale(glm::translate(glm::mat4(1), center), halfSize);
+	packed.verticies.reserve(verticies.size());
+	for (const TexVertex& vertex : verticies) {
+		glm::vec3 unit = glm::clamp((vertex.position - center) / halfSize, -1.f, 1.f);
+		packed.verticies.push_back({
+		    .position = glm::i16vec3(glm::round(unit * 32767.f)),
+		    .padding = 0,
+		    .normal = glm::packSnorm3x10_1x2(glm::vec4(vertex.normal, 0)),
+		    .texCoords = glm::packHalf2x16(vertex.texCoords),
+		});
+	}
+	return packed;
 }
 
 // add more as needed
 template class Mesh<TexVertex, Shaders::Object>;
+template class Mesh<TexVertex, Shaders::Object, ushort>;
+template class Mesh<PackedTexVertex, Shaders::Object>;
+template class Mesh<PackedTexVertex, Shaders::Object, ushort>;
 template class Mesh<ColorVertex, Shaders::Object>;
-template class Mesh<TexVertex, Shaders::Terrain>;
-template class Mesh<ColorVertex, Shaders::Terrain>;
+template class Mesh<TerrainVertex, Shaders::Terrain>;
+template class Mesh<TerrainVertex, Shaders::Terrain, ushort>;
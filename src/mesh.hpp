@@ -2,18 +2,33 @@
 #define MESH_HPP
 
 #include "common.hpp"
+#include "glHandle.hpp"
+#include "meshOptimizer.hpp"
 #include "object.hpp"
+#include "resourceManager.hpp"
 #include "sceneObject.hpp"
 #include "shaders.hpp"
+#include "terrain.hpp"
 
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/vector_float2.hpp>
 #include <glm/ext/vector_float3.hpp>
+#include <glm/ext/vector_int3_sized.hpp>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/packing.hpp>
 #include <glm/gtx/string_cast.hpp>
 
 #include <stb_image.h>
 
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <span>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #pragma pack(push, 1)
@@ -33,67 +48,310 @@ struct ColorVertex {
 	glm::vec3 specular;
 };
 
+// colors come from the terrain material, based on position.y
+struct TerrainVertex {
+	glm::vec3 position;
+	uint normal; // packed with glm::packSnorm3x10_1x2
+
+	glm::vec3 unpackNormal() const { return glm::vec3(glm::unpackSnorm3x10_1x2(this->normal)); }
+};
+
+// TexVertex in 16 bytes instead of 32, from packTexVerticies
+struct PackedTexVertex {
+	glm::i16vec3 position; // -1 to 1 across the mesh's bounding box, as 16 bit snorms
+	short padding; // keeps the rest 4 byte aligned
+	uint normal; // packed with glm::packSnorm3x10_1x2
+	uint texCoords; // packed with glm::packHalf2x16
+
+	// where it is in the bounding box; the mesh's dequantize matrix turns that into a position
+	glm::vec3 unpackPosition() const { return glm::max(glm::vec3(this->position) / 32767.f, -1.f); }
+
+	glm::vec3 unpackNormal() const { return glm::vec3(glm::unpackSnorm3x10_1x2(this->normal)); }
+
+	glm::vec2 unpackTexCoords() const { return glm::unpackHalf2x16(this->texCoords); }
+};
+
+#pragma pack(pop)
+
+// a mesh's verticies packed into PackedTexVertex
+struct PackedTexVerticies {
+	std::vector<PackedTexVertex> verticies;
+	// Turns unpacked positions back into the mesh's. Folded into obj2world when it's drawn.
+	glm::mat4 dequantize;
+};
+
+// Each position is off by at most half a 65535th of the mesh's size along each axis. Normals are
+// 10 bits per axis, and texture coordinates are half floats, with 11 bits of precision.
+PackedTexVerticies packTexVerticies(const std::span<const TexVertex> verticies);
+
 enum class TextureType { textureDiffuse, textureSpecular };
 
 struct Texture {
-	uint id;
+	std::shared_ptr<const GpuTexture> handle;
 	TextureType type;
 };
 
-#pragma pack(pop)
+// part of a mesh's index buffer, drawn with glDrawElementsBaseVertex
+struct DrawRange {
+	uint indexCount;
+	size_t firstIndex;
+	int baseVertex; // added to every index, so 16 bit indicies can reach further into the vertices
+};
+
+// a sphere around every vertex of a mesh
+struct MeshBounds {
+	glm::vec3 center;
+	float radius;
+};
+
+// where a vertex is, as it's stored
+template <typename Vertex> glm::vec3 storedPosition(const Vertex& vertex) {
+	if constexpr (requires { vertex.unpackPosition(); }) return vertex.unpackPosition();
+	else return vertex.position;
+}
+
+template <typename Vertex> MeshBounds meshBounds(const std::span<const Vertex> verticies) {
+	glm::vec3 low{std::numeric_limits<float>::max()};
+	glm::vec3 high{std::numeric_limits<float>::lowest()};
+	for (const Vertex& vertex : verticies) {
+		low = glm::min(low, storedPosition(vertex));
+		high = glm::max(high, storedPosition(vertex));
+	}
+	MeshBounds bounds{(low + high) / 2.f, 0};
+	for (const Vertex& vertex : verticies) {
+		bounds.radius =
+		    std::max(bounds.radius, glm::distance(storedPosition(vertex), bounds.center));
+	}
+	return bounds;
+}
+
+// how much transform scales things, along its most stretched axis
+inline float transformScale(const glm::mat4& transform) {
+	return std::max({glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])),
+	                 glm::length(glm::vec3(transform[2]))});
+}
+
+// a level is only drawn if it's off by less than this many pixels, so switching is invisible
+constexpr float lodPixelError = 1;
+constexpr float lodHysteresis = 1.25;
+
+// Picks the coarsest level of detail that's less than lodPixelError pixels off, drawn with
+// transform. Only goes coarser than current once a level is lodHysteresis times under that, so a
+// mesh sitting right at the boundary doesn't switch back and forth every frame.
+uint selectLod(const std::span<const MeshLod> lods, const uint current, const MeshBounds& bounds,
+               const Camera& camera, const glm::mat4& transform);
+
+// The level of detail each part of a mesh was drawn at last, 0 being the full mesh, which
+// selectLod needs for its hysteresis. Empty until the first draw. Kept per instance, since a mesh
+// the resource manager shares between models is a different distance from the camera in each.
+typedef std::vector<uint> LodSelection;
 
-// loads the file at runtime, so the path should be absolute or relative to the final binary
-[[nodiscard]] uint loadTexture(const filesystem::path& path);
+// binds textures to texture units from 0 up, and points the shader's material at them
+void bindTextures(const Shaders::Object& shader, const std::span<const Texture> textures);
+
+// whether a mesh keeps a copy of its geometry in RAM after uploading it
+enum class MeshStorage {
+	keepGeometry, // for meshes whose verticies are read or updated later
+	gpuOnly,
+};
+
+// Index is uint or ushort; ushort halves the index buffer, but can only reach 65536 vertices
+// from each range's baseVertex
+// Owns its VAO and buffers, so it's move only and deletes them when it's destroyed.
+template <typename Vertex, Shaders::Shader Shader, typename Index = uint>
+class Mesh : public BaseSceneGraphObject {
+	static_assert(std::is_same_v<Index, uint> or std::is_same_v<Index, ushort>);
 
-template <typename Vertex, Shaders::Shader Shader> class Mesh : public BaseSceneGraphObject {
   private:
 	Shader shader;
+	// CPU copies, which are empty for gpuOnly meshes
 	std::vector<Vertex> verticies;
-	std::vector<uint> indicies;
+	std::vector<Index> indicies;
+	size_t vertexCount;
+	size_t indexCount;
+	std::vector<DrawRange> ranges; // the whole index buffer by default
 	std::vector<Texture> textures; // TODO: this is useless if we aren't using textured verticies
 	float shininess;
-	uint VAO, VBO, EBO;
+	Shaders::TerrMaterial terrainMaterial; // only used by TerrainVertex
+	std::vector<MeshLod> lods; // empty unless there's more than the full mesh
+	LodSelection lod; // for when it's drawn as its own node rather than through a MeshInstance
+	MeshBounds bounds; // only set with lods, after dequantize
+	glm::mat4 dequantize; // identity unless the positions are packed
+	GlVertexArray VAO;
+	GlBuffer VBO, EBO;
+	// Drawn from instead of EBO when set. It belongs to whoever made it, so gpuBytes() doesn't
+	// count it, and it isn't filled by setupMesh.
+	std::shared_ptr<const GlBuffer> sharedEBO;
+
+	// fills VBO and EBO, and sets up VAO
+	void setupMesh(const std::span<const Vertex> verticies, const std::span<const Index> indicies);
 
-	// setup VAO, VB0, and EBO
-	void setupMesh();
+	// draws these parts of the index buffer; can assume the shader is correctly set
+	void drawRanges(const std::span<const DrawRange> ranges);
+
+	// frees the CPU copies, unless storage says to keep them
+	void applyStorage(const MeshStorage storage) {
+		if (storage == MeshStorage::keepGeometry) return;
+		// swapping with empty vectors actually frees the memory, unlike clear()
+		std::vector<Vertex>().swap(this->verticies);
+		std::vector<Index>().swap(this->indicies);
+	}
+
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
 
   public:
-	Mesh<TexVertex>(const std::vector<Vertex>& verticies, const std::vector<uint>& indicies,
+	// Uploads verticies and indicies without keeping a copy, so they can point into memory the
+	// mesh doesn't own, like a memory mapped file. Always gpuOnly. Works for TexVertex and
+	// PackedTexVertex, which also needs the dequantize matrix it was packed with.
+	// lods are parts of indicies, from buildMeshLods; it's drawn at the one that fits each frame.
+	Mesh<TexVertex>(const std::span<const Vertex> verticies, const std::span<const Index> indicies,
 	                const std::vector<Texture>& textures, const float shininess,
-	                const Shader shader)
+	                const Shader shader, const std::span<const MeshLod> lods = {},
+	                const glm::mat4& dequantize = glm::mat4(1))
 	    : BaseSceneGraphObject(glm::mat4(1)) {
 		this->shader = shader;
-		this->verticies = verticies;
-		this->indicies = indicies;
 		this->textures = textures;
 		this->shininess = shininess;
 
-		this->setupMesh();
+		this->setupMesh(verticies, indicies);
+		this->dequantize = dequantize;
+		if (lods.size() > 1) {
+			this->lods.assign(ALL_OF(lods));
+			this->ranges = {{lods[0].indexCount, lods[0].firstIndex, 0}};
+			// the LOD errors are in the mesh's units, so the bounds have to be too
+			MeshBounds stored = meshBounds(verticies);
+			this->bounds = {glm::vec3(dequantize * glm::vec4(stored.center, 1)),
+			                stored.radius * transformScale(dequantize)};
+		}
 	}
 
-	Mesh<ColorVertex>(const std::vector<Vertex>& verticies, const std::vector<uint>& indicies,
-	                  const float shininess, const Shader shader)
+	// pass the vectors with std::move to avoid copying them
+	Mesh<ColorVertex>(std::vector<Vertex> verticies, std::vector<Index> indicies,
+	                  const float shininess, const Shader shader,
+	                  const MeshStorage storage = MeshStorage::keepGeometry)
 	    : BaseSceneGraphObject(glm::mat4(1)) {
 		this->shader = shader;
-		this->verticies = verticies;
-		this->indicies = indicies;
+		this->verticies = std::move(verticies);
+		this->indicies = std::move(indicies);
 		this->shininess = shininess;
+
+		this->setupMesh(this->verticies, this->indicies);
+		this->applyStorage(storage);
+	}
+
+	// pass the vectors with std::move to avoid copying them
+	Mesh<TerrainVertex>(std::vector<Vertex> verticies, std::vector<Index> indicies,
+	                    const Shaders::TerrMaterial& material, const Shader shader,
+	                    const MeshStorage storage = MeshStorage::keepGeometry)
+	    : BaseSceneGraphObject(glm::mat4(1)) {
 		this->shader = shader;
+		this->verticies = std::move(verticies);
+		this->indicies = std::move(indicies);
+		this->shininess = material.shininess;
+		this->terrainMaterial = material;
 
-		this->setupMesh();
+		this->setupMesh(this->verticies, this->indicies);
+		this->applyStorage(storage);
 	}
 
+	// Uploads without keeping a copy, so the indicies can stay wherever they already are.
+	// Always gpuOnly.
+	Mesh<TerrainVertex>(const std::span<const Vertex> verticies,
+	                    const std::span<const Index> indicies,
+	                    const Shaders::TerrMaterial& material, const Shader shader)
+	    : BaseSceneGraphObject(glm::mat4(1)) {
+		this->shader = shader;
+		this->shininess = material.shininess;
+		this->terrainMaterial = material;
+
+		this->setupMesh(verticies, indicies);
+	}
+
+	// Uploads only the verticies, and draws with an index buffer that's already filled with
+	// indexCount indicies, so meshes with the same grid can share one, like streamed terrain
+	// chunks. Always gpuOnly.
+	Mesh<TerrainVertex>(const std::span<const Vertex> verticies,
+	                    const std::shared_ptr<const GlBuffer> sharedEBO, const size_t indexCount,
+	                    const Shaders::TerrMaterial& material, const Shader shader)
+	    : BaseSceneGraphObject(glm::mat4(1)) {
+		this->shader = shader;
+		this->shininess = material.shininess;
+		this->terrainMaterial = material;
+		this->sharedEBO = sharedEBO;
+
+		this->setupMesh(verticies, {});
+		this->indexCount = indexCount;
+		this->ranges = {{(uint)indexCount, 0, 0}};
+	}
+
+	Mesh(Mesh&&) = default;
+	Mesh& operator=(Mesh&&) = default;
+
 	virtual void print(const SceneCascade& cascade) {
 		std::println("{}Mesh:", std::string(SCENE_GRAPH_INDENT * cascade.recurseDepth, ' '));
 	}
 
+	// Draw these parts of the index buffer instead of all of it. Lets a mesh with more than
+	// 65536 vertices use 16 bit indicies, by splitting it into ranges that each reach fewer.
+	void setRanges(const std::vector<DrawRange>& ranges) { this->ranges = ranges; }
+
+	// empty if the mesh is gpuOnly
+	const std::vector<Vertex>& getVerticies() const { return this->verticies; }
+
+	// Replaces verticies starting at first, and only uploads those with glBufferSubData. Can't add
+	// verticies past the end. Updates the CPU copy too, if there is one.
+	void updateVerticies(const size_t first, const std::span<const Vertex> verticies);
+
 	// sets uniforms and stuff
-	virtual void render(const Camera& camera, const SceneCascade& cascade);
+	virtual void render(const Camera& camera, const SceneCascade& cascade) {
+		this->render(camera, cascade, this->lod);
+	}
+
+	// renders with lod as the level of detail state, for instances sharing this mesh
+	void render(const Camera& camera, const SceneCascade& cascade, LodSelection& lod);
 
 	// actually draws the object; can assume the shader is correctly set
-	void draw();
+	void draw() { this->drawRanges(this->ranges); }
+
+	// bytes of vertex and index data uploaded to the GPU, not counting a shared index buffer
+	size_t gpuBytes() const {
+		size_t indexBytes = this->sharedEBO ? 0 : this->indexCount * sizeof(Index);
+		return this->vertexCount * sizeof(Vertex) + indexBytes;
+	}
+
+	// bytes held by the CPU copies
+	size_t cpuBytes() const {
+		return this->verticies.capacity() * sizeof(Vertex)
+		     + this->indicies.capacity() * sizeof(Index);
+	}
 
 	virtual ~Mesh() = default;
 };
 
+// One instance of a mesh that's shared with others, like a Model's meshes, which every Model of
+// the same file gets from the resource manager. Draws it with this instance's own level of
+// detail. SharedMesh is a Mesh or MeshBatch.
+template <typename SharedMesh>
+class MeshInstance : public BaseSceneGraphNode {
+  private:
+	std::shared_ptr<SharedMesh> mesh;
+	LodSelection lod;
+
+  public:
+	MeshInstance(const std::shared_ptr<SharedMesh> mesh) : BaseSceneGraphNode() {
+		this->mesh = mesh;
+	}
+
+	virtual SceneCascade getNodeCascade() const { return this->mesh->getNodeCascade(); }
+
+	virtual void render(const Camera& camera, const SceneCascade& cascade) {
+		this->mesh->render(camera, cascade, this->lod);
+	}
+
+	virtual void print(const SceneCascade& cascade) { this->mesh->print(cascade); }
+
+	virtual ~MeshInstance() = default;
+};
+
 #endif /* MESH_HPP */
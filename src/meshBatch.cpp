@@ -0,0 +1,83 @@
+#include "meshBatch.hpp"
+
+#include "object.hpp"
+#include "shaderStructs.hpp"
+
+MeshBatch::MeshBatch(const std::span<const BatchedMesh> meshes, const Shaders::Object shader)
+    : BaseSceneGraphObject(glm::mat4(1)) {
+	this->shader = shader;
+	this->vertexCount = 0;
+	this->indexCount = 0;
+	for (const BatchedMesh& mesh : meshes) {
+		this->vertexCount += mesh.verticies.size();
+		this->indexCount += mesh.indicies.size();
+	}
+
+	glBindVertexArray(this->VAO.get());
+
+	// sized first, then filled a mesh at a time, so the meshes are never copied into one vector
+	glBindBuffer(GL_ARRAY_BUFFER, this->VBO.get());
+	glBufferData(GL_ARRAY_BUFFER, this->vertexCount * sizeof(TexVertex), nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO.get());
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indexCount * sizeof(uint), nullptr,
+	             GL_STATIC_DRAW);
+
+	size_t firstVertex = 0;
+	size_t firstIndex = 0;
+	for (const BatchedMesh& mesh : meshes) {
+		glBufferSubData(GL_ARRAY_BUFFER, firstVertex * sizeof(TexVertex),
+		                mesh.verticies.size_bytes(), mesh.verticies.data());
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, firstIndex * sizeof(uint),
+		                mesh.indicies.size_bytes(), mesh.indicies.data());
+
+		Part part{};
+		if (mesh.lods.empty()) part.lods = {{0, (uint)mesh.indicies.size(), 0}};
+		else part.lods.assign(ALL_OF(mesh.lods));
+		for (MeshLod& lod : part.lods) lod.firstIndex += firstIndex;
+		// the indicies stay as they were, and the draw adds this to them instead
+		part.baseVertex = firstVertex;
+		part.bounds = meshBounds(mesh.verticies);
+		part.textures = mesh.textures;
+		part.shininess = mesh.shininess;
+		this->parts.push_back(std::move(part));
+
+		firstVertex += mesh.verticies.size();
+		firstIndex += mesh.indicies.size();
+	}
+
+	STRUCT_MEMBER_ATTRIB(0, TexVertex, position);
+	STRUCT_MEMBER_ATTRIB(1, TexVertex, normal);
+	STRUCT_MEMBER_ATTRIB(2, TexVertex, texCoords);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void MeshBatch::render(const Camera& camera, const SceneCascade& cascade, LodSelection& lod) {
+	SceneCascade combinedCascade = cascade + this->getNodeCascade();
+	lod.resize(this->parts.size(), 0);
+
+	this->shader->use();
+	this->shader->setObj2world(combinedCascade.transform);
+	this->shader->setObj2normal(glm::mat3(glm::transpose(glm::inverse(combinedCascade.transform))));
+	this->shader->setWorld2cam(camera.toCamSpace());
+	this->shader->setProjection(camera.projectionMat());
+	this->shader->setViewPos(camera.getPosition());
+
+	glBindVertexArray(this->VAO.get());
+	for (size_t i = 0; i < this->parts.size(); i++) {
+		const Part& part = this->parts[i];
+		if (part.lods.size() > 1)
+			lod[i] = selectLod(part.lods, lod[i], part.bounds, camera, combinedCascade.transform);
+		const MeshLod& drawn = part.lods[lod[i]];
+
+		bindTextures(this->shader, part.textures);
+		this->shader->setUniform(Shaders::ObjectImpl::Uniform::material_shininess, part.shininess);
+		glDrawElementsBaseVertex(GL_TRIANGLES, drawn.indexCount, GL_UNSIGNED_INT,
+		                         (void*)(drawn.firstIndex * sizeof(uint)), part.baseVertex);
+	}
+	glBindVertexArray(0);
+
+	this->shader->stopUsing();
+}
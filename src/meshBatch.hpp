@@ -0,0 +1,78 @@
+#ifndef MESHBATCH_HPP
+#define MESHBATCH_HPP
+
+#include "common.hpp"
+#include "glHandle.hpp"
+#include "mesh.hpp"
+#include "meshOptimizer.hpp"
+#include "sceneObject.hpp"
+#include "shaders.hpp"
+
+#include <span>
+#include <vector>
+
+// one mesh going into a batch
+struct BatchedMesh {
+	std::span<const TexVertex> verticies;
+	std::span<const uint> indicies;
+	std::span<const MeshLod> lods; // parts of indicies, or empty to always draw all of them
+	std::vector<Texture> textures;
+	float shininess;
+};
+
+// Many textured meshes in one vertex buffer and one index buffer, like all of a model's meshes.
+// Each is drawn with glDrawElementsBaseVertex from the same VAO, so drawing the whole batch is one
+// VAO bind and one program use, instead of one per mesh. Each mesh still has its own textures,
+// shininess and level of detail. Owns its VAO and buffers, so it's move only.
+class MeshBatch : public BaseSceneGraphObject {
+  private:
+	// where one mesh is in the shared buffers
+	struct Part {
+		std::vector<MeshLod> lods; // moved to where its indicies are in the shared buffer
+		int baseVertex;
+		MeshBounds bounds;
+		std::vector<Texture> textures;
+		float shininess;
+	};
+
+	Shaders::Object shader;
+	std::vector<Part> parts;
+	LodSelection lod; // for when it's drawn as its own node rather than through a MeshInstance
+	size_t vertexCount;
+	size_t indexCount;
+	GlVertexArray VAO;
+	GlBuffer VBO, EBO;
+
+	MeshBatch(const MeshBatch&) = delete;
+	MeshBatch& operator=(const MeshBatch&) = delete;
+
+  public:
+	// uploads every mesh without keeping a copy, so they can point into a memory mapped file
+	MeshBatch(const std::span<const BatchedMesh> meshes, const Shaders::Object shader);
+
+	MeshBatch(MeshBatch&&) = default;
+	MeshBatch& operator=(MeshBatch&&) = default;
+
+	virtual void print(const SceneCascade& cascade) {
+		std::println("{}MeshBatch: {} meshes",
+		             std::string(SCENE_GRAPH_INDENT * cascade.recurseDepth, ' '),
+		             this->parts.size());
+	}
+
+	// sets uniforms once, and then draws every mesh
+	virtual void render(const Camera& camera, const SceneCascade& cascade) {
+		this->render(camera, cascade, this->lod);
+	}
+
+	// renders with lod as the level of detail state, one per mesh, for instances sharing the batch
+	void render(const Camera& camera, const SceneCascade& cascade, LodSelection& lod);
+
+	// bytes of vertex and index data uploaded to the GPU
+	size_t gpuBytes() const {
+		return this->vertexCount * sizeof(TexVertex) + this->indexCount * sizeof(uint);
+	}
+
+	virtual ~MeshBatch() = default;
+};
+
+#endif /* MESHBATCH_HPP */
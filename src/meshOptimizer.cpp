@@ -0,0 +1,266 @@
+#include "meshOptimizer.hpp"
+
+#include "mesh.hpp"
+
+#include <glm/ext/vector_double3.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+template <typename Vertex>
+MeshOptimizeStats optimizeMesh(std::vector<Vertex>& verticies, std::vector<uint>& indicies,
+                               const float overdrawThreshold) {
+	MeshOptimizeStats stats{};
+	stats.before = simulateVertexCache(indicies, verticies.size());
+
+	std::vector<glm::vec3> positions;
+	positions.reserve(verticies.size());
+	for (const Vertex& vertex : verticies) positions.push_back(vertex.position);
+
+	indicies = optimizeVertexCache(indicies, verticies.size());
+	indicies = optimizeOverdraw(indicies, positions, overdrawThreshold);
+
+	std::vector<uint> remap = optimizeVertexFetch(indicies, verticies.size());
+	std::vector<Vertex> reordered(verticies.size());
+	uint used = 0;
+	for (uint i = 0; i < verticies.size(); i++) {
+		if (remap[i] == unusedVertex) continue;
+		reordered[remap[i]] = verticies[i];
+		used++;
+	}
+	reordered.resize(used);
+	verticies = std::move(reordered);
+
+	stats.after = simulateVertexCache(indicies, verticies.size());
+	return stats;
+}
+
+// The squared distance to a set of planes, as a symmetric 4x4 matrix: the upper triangle of
+// [n n^T, n d; n^T d, d^2], summed over every plane n . p + d = 0.
+struct Quadric {
+	std::array<double, 10> terms{};
+
+	static Quadric plane(const glm::dvec3& normal, const double offset) {
+		const glm::dvec3& n = normal;
+		const double d = offset;
+		return {{n.x * n.x, n.x * n.y, n.x * n.z, n.x * d, n.y * n.y, n.y * n.z, n.y * d, n.z * n.z,
+		         n.z * d, d * d}};
+	}
+
+	Quadric& operator+=(const Quadric& other) {
+		for (uint i = 0; i < this->terms.size(); i++) this->terms[i] += other.terms[i];
+		return *this;
+	}
+
+	double error(const glm::dvec3& p) const {
+		const std::array<double, 10>& q = this->terms;
+		return q[0] * p.x * p.x + 2 * q[1] * p.x * p.y + 2 * q[2] * p.x * p.z + 2 * q[3] * p.x
+		     + q[4] * p.y * p.y + 2 * q[5] * p.y * p.z + 2 * q[6] * p.y + q[7] * p.z * p.z
+		     + 2 * q[8] * p.z + q[9];
+	}
+};
+
+// vertices that have to stay where they are
+static std::vector<bool> lockedVerticies(const std::span<const glm::vec3> positions,
+                                         const std::span<const uint> indicies) {
+	// vertices that share a position are one vertex on a seam, where the attributes change
+	auto positionKey = [](const glm::vec3& p) {
+		return std::array<uint, 3>{std::bit_cast<uint>(p.x), std::bit_cast<uint>(p.y),
+		                           std::bit_cast<uint>(p.z)};
+	};
+	auto hashKey = [](const std::array<uint, 3>& key) {
+		return ((size_t)key[0] * 73'856'093) ^ ((size_t)key[1] * 19'349'663)
+		     ^ ((size_t)key[2] * 83'492'791);
+	};
+	std::unordered_map<std::array<uint, 3>, uint, decltype(hashKey)> welded{positions.size(),
+	                                                                      hashKey};
+	std::vector<uint> weld(positions.size());
+	std::vector<uint> shared(positions.size(), 0);
+	for (uint i = 0; i < positions.size(); i++) {
+		weld[i] = welded.try_emplace(positionKey(positions[i]), i).first->second;
+		shared[weld[i]]++;
+	}
+
+	// welded vertices are locked together, since they're the same vertex
+	std::vector<bool> lockedWelds(positions.size());
+	for (uint i = 0; i < positions.size(); i++) {
+		if (shared[weld[i]] > 1) lockedWelds[weld[i]] = true;
+	}
+
+	// an edge only one triangle has is on the border, once seams are welded shut
+	std::unordered_map<ulong, uint> edges;
+	for (size_t t = 0; t < indicies.size(); t += 3) {
+		for (uint corner = 0; corner < 3; corner++) {
+			uint a = weld[indicies[t + corner]];
+			uint b = weld[indicies[t + (corner + 1) % 3]];
+			edges[(ulong)std::min(a, b) << 32 | std::max(a, b)]++;
+		}
+	}
+	for (const auto& [edge, count] : edges) {
+		if (count != 1) continue;
+		lockedWelds[edge >> 32] = true;
+		lockedWelds[edge & 0xFFFF'FFFF] = true;
+	}
+
+	std::vector<bool> locked(positions.size());
+	for (uint i = 0; i < positions.size(); i++) locked[i] = lockedWelds[weld[i]];
+	return locked;
+}
+
+// whether moving vertex from to to turns any of its other triangles over
+static bool collapseFlips(const std::span<const glm::vec3> positions,
+                          const std::span<const uint> indicies,
+                          const std::span<const uint> triangles, const uint from, const uint to) {
+	for (uint t : triangles) {
+		const uint* triangle = &indicies[t * 3];
+		if (triangle[0] == to or triangle[1] == to or triangle[2] == to) continue; // goes away
+		std::array<glm::vec3, 3> corners;
+		for (uint i = 0; i < 3; i++) corners[i] = positions[triangle[i]];
+		glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+		for (uint i = 0; i < 3; i++) {
+			if (triangle[i] == from) corners[i] = positions[to];
+		}
+		glm::vec3 after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+		if (glm::dot(before, after) <= 0) return true;
+	}
+	return false;
+}
+
+std::vector<uint> simplifyMesh(const std::span<const glm::vec3> positions,
+                               const std::span<const uint> indicies,
+                               const size_t targetIndexCount, float& error) {
+	std::vector<uint> current(ALL_OF(indicies));
+	const std::vector<bool> locked = lockedVerticies(positions, indicies);
+
+	std::vector<Quadric> quadrics(positions.size());
+	for (size_t t = 0; t < current.size(); t += 3) {
+		glm::dvec3 a{positions[current[t]]};
+		glm::dvec3 normal = glm::cross(glm::dvec3(positions[current[t + 1]]) - a,
+		                               glm::dvec3(positions[current[t + 2]]) - a);
+		double length = glm::length(normal);
+		if (length == 0) continue;
+		normal /= length;
+		Quadric plane = Quadric::plane(normal, -glm::dot(normal, a));
+		for (uint i = 0; i < 3; i++) quadrics[current[t + i]] += plane;
+	}
+
+	struct Collapse {
+		uint from;
+		uint to;
+		double cost;
+	};
+	std::vector<Collapse> candidates;
+	std::vector<uint> remap(positions.size());
+	std::vector<bool> touched(positions.size());
+	// which triangles use each vertex, packed like a CSR matrix
+	std::vector<uint> firstTriangle(positions.size() + 1);
+	std::vector<uint> vertexTriangles;
+
+	double maxCost = 0;
+	// Each pass collapses the cheapest edges that don't touch each other, so every collapse sees
+	// the mesh as it was at the start of the pass.
+	while (current.size() > targetIndexCount) {
+		const uint triangleCount = current.size() / 3;
+		std::ranges::fill(firstTriangle, 0);
+		for (uint index : current) firstTriangle[index + 1]++;
+		for (uint i = 0; i < positions.size(); i++) firstTriangle[i + 1] += firstTriangle[i];
+		vertexTriangles.resize(current.size());
+		std::vector<uint> filled(ALL_OF(firstTriangle));
+		for (uint t = 0; t < triangleCount; t++) {
+			for (uint i = 0; i < 3; i++) vertexTriangles[filled[current[t * 3 + i]]++] = t;
+		}
+
+		candidates.clear();
+		for (uint t = 0; t < triangleCount; t++) {
+			for (uint corner = 0; corner < 3; corner++) {
+				uint a = current[t * 3 + corner];
+				uint b = current[t * 3 + (corner + 1) % 3];
+				for (auto [from, to] : {std::pair{a, b}, std::pair{b, a}}) {
+					if (locked[from]) continue;
+					Quadric combined = quadrics[from];
+					combined += quadrics[to];
+					candidates.push_back({from, to, combined.error(glm::dvec3(positions[to]))});
+				}
+			}
+		}
+		std::ranges::sort(candidates, {}, &Collapse::cost);
+
+		std::iota(ALL_OF(remap), 0);
+		std::fill(ALL_OF(touched), false);
+		// each collapse takes about two triangles with it
+		const size_t wanted = (current.size() - targetIndexCount) / 3 / 2 + 1;
+		size_t collapsed = 0;
+		for (const Collapse& collapse : candidates) {
+			if (collapsed >= wanted) break;
+			if (touched[collapse.from] or touched[collapse.to]) continue;
+			const uint from = collapse.from;
+			std::span<const uint> around{vertexTriangles.begin() + firstTriangle[from],
+			                             vertexTriangles.begin() + firstTriangle[from + 1]};
+			if (collapseFlips(positions, current, around, collapse.from, collapse.to)) continue;
+
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to] += quadrics[collapse.from];
+			maxCost = std::max(maxCost, collapse.cost);
+			collapsed++;
+			// neighbors are left alone for the rest of the pass, so nothing else moves under
+			// the triangles that were just checked
+			for (uint t : around) {
+				for (uint i = 0; i < 3; i++) touched[current[t * 3 + i]] = true;
+			}
+		}
+		if (collapsed == 0) break;
+
+		size_t kept = 0;
+		for (size_t t = 0; t < current.size(); t += 3) {
+			uint a = remap[current[t]];
+			uint b = remap[current[t + 1]];
+			uint c = remap[current[t + 2]];
+			if (a == b or b == c or c == a) continue;
+			current[kept++] = a;
+			current[kept++] = b;
+			current[kept++] = c;
+		}
+		current.resize(kept);
+	}
+
+	error = std::sqrt(maxCost);
+	return current;
+}
+
+template <typename Vertex>
+std::vector<MeshLod> buildMeshLods(const std::vector<Vertex>& verticies,
+                                   std::vector<uint>& indicies) {
+	std::vector<glm::vec3> positions;
+	positions.reserve(verticies.size());
+	for (const Vertex& vertex : verticies) positions.push_back(vertex.position);
+
+	std::vector<MeshLod> lods{{0, (uint)indicies.size(), 0}};
+	std::vector<uint> previous = indicies;
+	while (lods.size() < maxMeshLods) {
+		float error;
+		std::vector<uint> simpler = simplifyMesh(positions, previous, previous.size() / 2, error);
+		// stuck on locked vertices, so another level would barely draw less
+		if (simpler.empty() or simpler.size() > previous.size() * 3 / 4) break;
+
+		simpler = optimizeVertexCache(simpler, verticies.size());
+		// errors add up, since each level is simplified from the one before
+		lods.push_back({(uint)indicies.size(), (uint)simpler.size(), lods.back().error + error});
+		indicies.insert(indicies.end(), ALL_OF(simpler));
+		previous = std::move(simpler);
+	}
+	return lods;
+}
+
+// add more as needed
+template MeshOptimizeStats optimizeMesh(std::vector<TexVertex>&, std::vector<uint>&, const float);
+template MeshOptimizeStats optimizeMesh(std::vector<ColorVertex>&, std::vector<uint>&,
+                                        const float);
+template std::vector<MeshLod> buildMeshLods(const std::vector<TexVertex>&, std::vector<uint>&);
+template std::vector<MeshLod> buildMeshLods(const std::vector<ColorVertex>&, std::vector<uint>&);
@@ -0,0 +1,55 @@
+#ifndef MESHOPTIMIZER_HPP
+#define MESHOPTIMIZER_HPP
+
+#include "common.hpp"
+#include "vertexCache.hpp"
+
+#include <glm/ext/vector_float3.hpp>
+
+#include <span>
+#include <vector>
+
+// how much a mesh's cache use changed, simulated with a 32 vertex cache
+struct MeshOptimizeStats {
+	VertexCacheStats before;
+	VertexCacheStats after;
+};
+
+// lets the triangle order use up to 5% more cache misses to cut overdraw
+constexpr float defaultOverdrawThreshold = 1.05;
+
+// Reorders a mesh before it's uploaded: its triangles for the vertex cache and then for less
+// overdraw, and then its vertices in the order they're first used. Vertices no triangle uses are
+// dropped. The mesh looks exactly the same. Works for any vertex with a position, and is
+// instantiated for TexVertex and ColorVertex.
+template <typename Vertex>
+MeshOptimizeStats optimizeMesh(std::vector<Vertex>& verticies, std::vector<uint>& indicies,
+                               const float overdrawThreshold = defaultOverdrawThreshold);
+
+// one level of detail, as a part of its mesh's index buffer
+struct MeshLod {
+	uint firstIndex;
+	uint indexCount;
+	float error; // how far it can be from the full mesh, in the mesh's units
+};
+
+// a mesh gets at most this many levels, counting the full one
+constexpr uint maxMeshLods = 5;
+
+// Simplifies a mesh to about targetIndexCount indicies, by collapsing the edges that cost the
+// least quadric error (Garland and Heckbert) first. A vertex is only ever collapsed onto a
+// neighbor, so the result uses the same vertices. Vertices on the mesh's border, or on a seam
+// where vertices share a position, never move, so the outline and texture seams stay put.
+// error is set to how far the result can be from the original.
+std::vector<uint> simplifyMesh(const std::span<const glm::vec3> positions,
+                               const std::span<const uint> indicies,
+                               const size_t targetIndexCount, float& error);
+
+// Builds coarser and coarser levels of detail from an optimized mesh, each with about half the
+// triangles, until simplifying stops paying off. Their indicies are appended to indicies, so they
+// all share one index buffer. Returns the levels, starting with the full mesh.
+template <typename Vertex>
+std::vector<MeshLod> buildMeshLods(const std::vector<Vertex>& verticies,
+                                   std::vector<uint>& indicies);
+
+#endif /* MESHOPTIMIZER_HPP */
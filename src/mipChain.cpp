@@ -0,0 +1,435 @@
+#include "mipChain.hpp"
+
+#include <glad/gl.h>
+
+#include <glm/common.hpp>
+
+#include <stb_dxt.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+// S3TC is an extension, so glad wasn't generated with it
+static constexpr GLenum compressedRgbDxt1 = 0x83F0;
+static constexpr GLenum compressedRgbaDxt5 = 0x83F3;
+
+// bump whenever the filtering, compression or file layout changes, so old caches are ignored
+static constexpr uint textureCacheVersion = 1;
+static constexpr std::array<char, 4> textureCacheMagic{'T', 'E', 'X', 'C'};
+
+static bool compressTextures = false;
+
+void setTextureCompression(const bool compress) { compressTextures = compress; }
+
+bool getTextureCompression() { return compressTextures; }
+
+bool textureCompressionSupported() {
+	int count;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (int i = 0; i < count; i++) {
+		std::string_view extension{(const char*)glGetStringi(GL_EXTENSIONS, i)};
+		if (extension == "GL_EXT_texture_compression_s3tc") return true;
+	}
+	return false;
+}
+
+static DecodedImage decodeImage(const std::span<const std::byte> file,
+                                const filesystem::path& path) {
+	// the flip is per thread, so decoding on other threads doesn't race over it
+	stbi_set_flip_vertically_on_load_thread(true);
+
+	const stbi_uc* bytes = reinterpret_cast<const stbi_uc*>(file.data());
+	DecodedImage image;
+	int channels;
+	if (stbi_info_from_memory(bytes, file.size(), &image.width, &image.height, &channels)) {
+		// so everything after only has to handle rgb and rgba
+		image.channels = channels < 3 ? channels + 2 : channels;
+		image.pixels.reset(stbi_load_from_memory(bytes, file.size(), &image.width, &image.height,
+		                                         &channels, image.channels));
+	}
+
+	if (not image.pixels) {
+		throw std::runtime_error(std::format("Error loading image at {}.", path.string()));
+	}
+	return image;
+}
+
+DecodedImage decodeImage(const filesystem::path& path) {
+	std::optional<MappedFile> file = MappedFile::open(path);
+	if (not file.has_value()) {
+		throw std::runtime_error(std::format("Error loading image at {}.", path.string()));
+	}
+	return decodeImage({file->getData(), file->getSize()}, path);
+}
+
+// sRGB encoded bytes to linear values and back
+struct SrgbTables {
+	std::array<float, 256> toLinear;
+	std::array<uchar, 4096> fromLinear; // indexed by linear * 4095
+
+	SrgbTables() {
+		for (uint i = 0; i < this->toLinear.size(); i++) {
+			float srgb = i / 255.0f;
+			this->toLinear[i] =
+			    srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+		}
+		for (uint i = 0; i < this->fromLinear.size(); i++) {
+			float linear = i / 4095.0f;
+			float srgb = linear <= 0.0031308f ? linear * 12.92f
+			                                  : 1.055f * std::pow(linear, 1 / 2.4f) - 0.055f;
+			this->fromLinear[i] = std::lround(srgb * 255);
+		}
+	}
+};
+
+static const SrgbTables& srgbTables() {
+	static const SrgbTables tables;
+	return tables;
+}
+
+// one source pixel that a destination pixel covers, and how much of the destination it makes up
+struct FilterTap {
+	uint source;
+	float weight;
+};
+
+// the taps for each destination pixel when from pixels are shrunk to to, along one axis
+static std::vector<std::vector<FilterTap>> areaFilter(const uint from, const uint to) {
+	std::vector<std::vector<FilterTap>> taps(to);
+	const float scale = (float)from / to;
+	for (uint i = 0; i < to; i++) {
+		float begin = i * scale;
+		float end = (i + 1) * scale;
+		uint last = std::min((uint)std::ceil(end), from);
+		for (uint source = (uint)begin; source < last; source++) {
+			float overlap = std::min(end, source + 1.0f) - std::max(begin, (float)source);
+			if (overlap > 0) taps[i].push_back({source, overlap / scale});
+		}
+	}
+	return taps;
+}
+
+// Shrinks an image of channels floats per pixel. Works along x, then y, so each pixel only looks
+// at one row or column of taps at a time.
+static std::vector<float> downsample(const std::vector<float>& source, const glm::uvec2 from,
+                                     const glm::uvec2 to, const uint channels) {
+	std::vector<std::vector<FilterTap>> tapsX = areaFilter(from.x, to.x);
+	std::vector<std::vector<FilterTap>> tapsY = areaFilter(from.y, to.y);
+
+	std::vector<float> rows((size_t)to.x * from.y * channels, 0);
+	for (uint y = 0; y < from.y; y++) {
+		const float* sourceRow = source.data() + (size_t)y * from.x * channels;
+		float* row = rows.data() + (size_t)y * to.x * channels;
+		for (uint x = 0; x < to.x; x++) {
+			for (const FilterTap& tap : tapsX[x]) {
+				for (uint c = 0; c < channels; c++) {
+					row[x * channels + c] += sourceRow[tap.source * channels + c] * tap.weight;
+				}
+			}
+		}
+	}
+
+	const size_t rowLength = (size_t)to.x * channels;
+	std::vector<float> result(rowLength * to.y, 0);
+	for (uint y = 0; y < to.y; y++) {
+		float* row = result.data() + y * rowLength;
+		for (const FilterTap& tap : tapsY[y]) {
+			const float* sourceRow = rows.data() + tap.source * rowLength;
+			for (size_t i = 0; i < rowLength; i++) row[i] += sourceRow[i] * tap.weight;
+		}
+	}
+	return result;
+}
+
+// BC1 blocks, or BC3 with alpha, for one level of rgb or rgba pixels
+// blocks hanging off the edge repeat the last row and column
+static void compressLevel(const uchar* pixels, const glm::uvec2 size, const uint channels,
+                          std::vector<std::byte>& out) {
+	const bool alpha = channels == 4;
+	const uint blockBytes = alpha ? 16 : 8;
+	const glm::uvec2 blocks = (size + 3u) / 4u;
+	const size_t start = out.size();
+	out.resize(start + (size_t)blocks.x * blocks.y * blockBytes);
+
+	std::array<uchar, 4 * 4 * 4> block; // always rgba
+	for (uint blockY = 0; blockY < blocks.y; blockY++) {
+		for (uint blockX = 0; blockX < blocks.x; blockX++) {
+			for (uint y = 0; y < 4; y++) {
+				for (uint x = 0; x < 4; x++) {
+					uint sourceX = std::min(blockX * 4 + x, size.x - 1);
+					uint sourceY = std::min(blockY * 4 + y, size.y - 1);
+					const uchar* pixel = pixels + ((size_t)sourceY * size.x + sourceX) * channels;
+					uchar* blockPixel = block.data() + (y * 4 + x) * 4;
+					std::copy_n(pixel, channels, blockPixel);
+					if (not alpha) blockPixel[3] = 255;
+				}
+			}
+			uchar* dest = reinterpret_cast<uchar*>(out.data() + start)
+			            + ((size_t)blockY * blocks.x + blockX) * blockBytes;
+			stb_compress_dxt_block(dest, block.data(), alpha, STB_DXT_HIGHQUAL);
+		}
+	}
+}
+
+MipChain buildMipChain(const DecodedImage& image, const bool color, const bool compress) {
+	const uint channels = image.channels;
+	const SrgbTables& tables = srgbTables();
+	// alpha is never a color
+	const uint colorChannels = color ? 3 : 0;
+
+	MipChain chain;
+	chain.format = compress ? (channels == 4 ? PixelFormat::bc3 : PixelFormat::bc1)
+	                        : (channels == 4 ? PixelFormat::rgba8 : PixelFormat::rgb8);
+
+	glm::uvec2 size{image.width, image.height};
+	const uchar* pixels = image.pixels.get();
+	std::vector<size_t> levelStarts;
+	std::vector<uchar> quantized;
+	std::vector<float> linear;
+	while (true) {
+		chain.sizes.push_back(size);
+		levelStarts.push_back(chain.storage.size());
+		const size_t values = (size_t)size.x * size.y * channels;
+		if (compress) compressLevel(pixels, size, channels, chain.storage);
+		else {
+			const std::byte* bytes = reinterpret_cast<const std::byte*>(pixels);
+			chain.storage.insert(chain.storage.end(), bytes, bytes + values);
+		}
+		if (size == glm::uvec2(1)) break;
+
+		// the full size level comes straight from the image, and each one after from the floats
+		// of the level above, so rounding errors don't build up
+		if (linear.empty()) {
+			linear.resize(values);
+			for (size_t i = 0; i < values; i++) {
+				linear[i] = i % channels < colorChannels ? tables.toLinear[pixels[i]]
+				                                         : pixels[i] / 255.0f;
+			}
+		}
+
+		glm::uvec2 next = glm::max(size / 2u, glm::uvec2(1));
+		linear = downsample(linear, size, next, channels);
+		size = next;
+
+		quantized.resize(linear.size());
+		for (size_t i = 0; i < linear.size(); i++) {
+			float value = std::clamp(linear[i], 0.0f, 1.0f);
+			if (i % channels < colorChannels)
+				quantized[i] = tables.fromLinear[std::lround(value * 4095)];
+			else quantized[i] = std::lround(value * 255);
+		}
+		pixels = quantized.data();
+	}
+
+	// storage is done growing, so the levels can point into it
+	levelStarts.push_back(chain.storage.size());
+	for (uint level = 0; level < chain.sizes.size(); level++) {
+		chain.levels.push_back(std::span<const std::byte>(chain.storage)
+		                           .subspan(levelStarts[level],
+		                                    levelStarts[level + 1] - levelStarts[level]));
+	}
+	return chain;
+}
+
+// start of a texture cache file, followed by a TextureCacheLevel for each level, then the levels
+// themselves, each padded to 4 bytes
+struct TextureCacheHeader {
+	std::array<char, 4> magic;
+	uint version;
+	ulong key;
+	PixelFormat format;
+	uint levelCount;
+};
+
+struct TextureCacheLevel {
+	uint width;
+	uint height;
+	ulong size; // in bytes
+};
+
+static constexpr size_t padTo4(const size_t size) { return (size + 3) / 4 * 4; }
+
+// nullopt if the cache file doesn't exist or doesn't match
+static std::optional<MipChain> readMipCache(const filesystem::path& path, const ulong key) {
+	std::optional<MappedFile> file = MappedFile::open(path);
+	if (not file.has_value()) return std::nullopt;
+
+	// hands out the file piece by piece, or null once it runs out
+	size_t offset = 0;
+	auto take = [&](const size_t size) -> const std::byte* {
+		if (offset + size > file->getSize()) return nullptr;
+		const std::byte* piece = file->getData() + offset;
+		offset += padTo4(size);
+		return piece;
+	};
+
+	const auto* header =
+	    reinterpret_cast<const TextureCacheHeader*>(take(sizeof(TextureCacheHeader)));
+	if (not header or header->magic != textureCacheMagic or header->version != textureCacheVersion
+	    or header->key != key or header->format > PixelFormat::bc3 or header->levelCount == 0
+	    or header->levelCount > 32)
+		return std::nullopt;
+	const auto* levels = reinterpret_cast<const TextureCacheLevel*>(
+	    take(header->levelCount * sizeof(TextureCacheLevel)));
+	if (not levels) return std::nullopt;
+
+	MipChain chain;
+	chain.format = header->format;
+	for (uint i = 0; i < header->levelCount; i++) {
+		const std::byte* pixels = take(levels[i].size);
+		if (not pixels) return std::nullopt;
+		chain.sizes.push_back({levels[i].width, levels[i].height});
+		chain.levels.push_back({pixels, levels[i].size});
+	}
+
+	// the levels point into the mapping, so it has to live as long as they do
+	chain.file = std::move(file);
+	return chain;
+}
+
+static void writeMipCache(const filesystem::path& path, const ulong key, const MipChain& chain) {
+	const TextureCacheHeader header{textureCacheMagic, textureCacheVersion, key, chain.format,
+	                                (uint)chain.levels.size()};
+	std::vector<TextureCacheLevel> levels;
+	for (uint i = 0; i < chain.levels.size(); i++) {
+		levels.push_back({chain.sizes[i].x, chain.sizes[i].y, chain.levels[i].size()});
+	}
+
+	static constexpr std::array<std::byte, 3> padding{};
+	std::vector<std::span<const std::byte>> parts{
+	    std::as_bytes(std::span(&header, 1)),
+	    std::as_bytes(std::span(levels)),
+	};
+	for (std::span<const std::byte> level : chain.levels) {
+		parts.push_back(level);
+		parts.push_back(std::span(padding).first(padTo4(level.size()) - level.size()));
+	}
+	writeCacheFile(path, parts);
+}
+
+MipChain loadMipChain(const filesystem::path& path, const bool color) {
+	const bool compress = getTextureCompression();
+	std::optional<MappedFile> source = MappedFile::open(path);
+	if (not source.has_value()) {
+		throw std::runtime_error(std::format("Error loading image at {}.", path.string()));
+	}
+
+	std::optional<filesystem::path> cacheFile;
+	ulong key = 0;
+	if (getCacheDir().has_value()) {
+		key = CacheKey()
+		          .add("texture")
+		          .add(textureCacheVersion)
+		          .add(color)
+		          .add(compress)
+		          .add(source->getData(), source->getSize())
+		          .get();
+		cacheFile = cachePath("textures", key, "mips");
+		std::optional<MipChain> cached = readMipCache(*cacheFile, key);
+		if (cached.has_value()) return std::move(*cached);
+	}
+
+	MipChain chain = buildMipChain(decodeImage({source->getData(), source->getSize()}, path),
+	                               color, compress);
+	if (cacheFile.has_value()) writeMipCache(*cacheFile, key, chain);
+	return chain;
+}
+
+// what a pixel format is called in OpenGL
+struct GlPixelFormat {
+	GLenum internalFormat;
+	GLenum format; // of the pixels uploaded, unless it's compressed
+	bool compressed;
+};
+
+static GlPixelFormat glPixelFormat(const PixelFormat format) {
+	switch (format) {
+	case PixelFormat::rgb8: return {GL_RGB, GL_RGB, false};
+	case PixelFormat::rgba8: return {GL_RGBA, GL_RGBA, false};
+	case PixelFormat::bc1: return {compressedRgbDxt1, 0, true};
+	case PixelFormat::bc3: return {compressedRgbaDxt5, 0, true};
+	}
+	throw std::logic_error(std::format("Unknown pixel format {}.", (uint)format));
+}
+
+uint uploadMipChain(const MipChain& chain) {
+	uint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	// rgb rows aren't padded out to 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	const GlPixelFormat format = glPixelFormat(chain.format);
+	for (uint level = 0; level < chain.levels.size(); level++) {
+		const glm::uvec2 size = chain.sizes[level];
+		const std::span<const std::byte> pixels = chain.levels[level];
+		if (format.compressed) {
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, format.internalFormat, size.x, size.y, 0,
+			                       pixels.size(), pixels.data());
+		} else {
+			glTexImage2D(GL_TEXTURE_2D, level, format.internalFormat, size.x, size.y, 0,
+			             format.format, GL_UNSIGNED_BYTE, pixels.data());
+		}
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, chain.levels.size() - 1);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texture;
+}
+
+uint allocateMipChain(const MipChain& chain) {
+	uint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	// null data with no unpack buffer bound just makes room
+	const GlPixelFormat format = glPixelFormat(chain.format);
+	for (uint level = 0; level < chain.levels.size(); level++) {
+		const glm::uvec2 size = chain.sizes[level];
+		if (format.compressed) {
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, format.internalFormat, size.x, size.y, 0,
+			                       chain.levels[level].size(), nullptr);
+		} else {
+			glTexImage2D(GL_TEXTURE_2D, level, format.internalFormat, size.x, size.y, 0,
+			             format.format, GL_UNSIGNED_BYTE, nullptr);
+		}
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, chain.levels.size() - 1);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texture;
+}
+
+uint mipLevelRows(const MipChain& chain, const uint level) {
+	const uint height = chain.sizes[level].y;
+	return glPixelFormat(chain.format).compressed ? (height + 3) / 4 : height;
+}
+
+void uploadMipRows(const MipChain& chain, const uint level, const uint firstRow,
+                   const uint rowCount, const void* pixels) {
+	const glm::uvec2 size = chain.sizes[level];
+	const size_t rowBytes = chain.levels[level].size() / mipLevelRows(chain, level);
+	const GlPixelFormat format = glPixelFormat(chain.format);
+	if (format.compressed) {
+		// the last block row can hang off the bottom of a level that isn't a multiple of 4 tall
+		const uint y = firstRow * 4;
+		const uint height = std::min(rowCount * 4, size.y - y);
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, y, size.x, height,
+		                          format.internalFormat, rowCount * rowBytes, pixels);
+	} else {
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, firstRow, size.x, rowCount, format.format,
+		                GL_UNSIGNED_BYTE, pixels);
+	}
+}
+
+size_t mipChainBytes(const MipChain& chain) {
+	size_t bytes = 0;
+	for (std::span<const std::byte> level : chain.levels) bytes += level.size();
+	return bytes;
+}
@@ -0,0 +1,87 @@
+#ifndef MIPCHAIN_HPP
+#define MIPCHAIN_HPP
+
+#include "common.hpp"
+#include "diskCache.hpp"
+
+#include <glm/ext/vector_uint2.hpp>
+
+#include <stb_image.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+// pixels read from an image file, flipped for OpenGL but not uploaded yet
+struct DecodedImage {
+	int width;
+	int height;
+	int channels; // 3 or 4; grey images are expanded to rgb or rgba
+	std::unique_ptr<uchar, decltype(&stbi_image_free)> pixels{nullptr, stbi_image_free};
+};
+
+// Reads and decodes an image file. Doesn't touch OpenGL, so any thread can call it. The path
+// should be absolute or relative to the final binary.
+[[nodiscard]] DecodedImage decodeImage(const filesystem::path& path);
+
+// how the levels of a mip chain are stored
+enum class PixelFormat : uint { rgb8, rgba8, bc1, bc3 };
+
+// Every level of a texture, from full size down to 1x1, ready to upload as it is. Move only,
+// since levels point into file or storage.
+struct MipChain {
+	PixelFormat format;
+	std::vector<glm::uvec2> sizes;
+	std::vector<std::span<const std::byte>> levels;
+	std::optional<MappedFile> file; // if it came from the texture cache
+	std::vector<std::byte> storage; // if it was built
+
+	MipChain() = default;
+
+	// moving the file or storage keeps their data where it is, so the levels stay valid
+	MipChain(const MipChain&) = delete;
+	MipChain& operator=(const MipChain&) = delete;
+	MipChain(MipChain&&) = default;
+	MipChain& operator=(MipChain&&) = default;
+};
+
+// Whether mip chains loaded from now on are block compressed, with BC1, or BC3 if they have alpha.
+// Off until it's turned on, which should only happen if textureCompressionSupported().
+void setTextureCompression(const bool compress);
+bool getTextureCompression();
+
+// whether the GL context can upload compressed mip chains; main thread only
+bool textureCompressionSupported();
+
+// Builds every mip level on the CPU. Each level is an area average of the one above it, done in
+// linear space if the image is a color, since that's how light adds up.
+MipChain buildMipChain(const DecodedImage& image, const bool color, const bool compress);
+
+// Memory maps the image's mip chain from the texture cache, or builds it and writes it to the
+// cache. The cache is keyed by the image file's contents. Doesn't touch OpenGL, so any thread can
+// call it.
+MipChain loadMipChain(const filesystem::path& path, const bool color);
+
+// Uploads every level as it is, so nothing is generated on the GPU. Main thread only.
+[[nodiscard]] uint uploadMipChain(const MipChain& chain);
+
+// Makes a texture with room for every level of chain, but nothing in them yet. Main thread only.
+[[nodiscard]] uint allocateMipChain(const MipChain& chain);
+
+// How many rows a level is uploaded in. Compressed levels are counted in rows of blocks, which are
+// 4 pixels tall, since they can't be split any finer.
+uint mipLevelRows(const MipChain& chain, const uint level);
+
+// Uploads some rows of a level to the bound texture, made by allocateMipChain. pixels is an
+// offset into GL_PIXEL_UNPACK_BUFFER if one's bound. The unpack alignment has to be 1. Main thread
+// only.
+void uploadMipRows(const MipChain& chain, const uint level, const uint firstRow,
+                   const uint rowCount, const void* pixels);
+
+// bytes in every level
+size_t mipChainBytes(const MipChain& chain);
+
+#endif /* MIPCHAIN_HPP */
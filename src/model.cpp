@@ -1,66 +1,289 @@
 #include "model.hpp"
 
 #include "assimp2glm.hpp"
+#include "mipChain.hpp"
 #include "object.hpp"
+#include "resourceManager.hpp"
+#include "startupReport.hpp"
+#include "textureStreamer.hpp"
+#include "threadPool.hpp"
 
-void loadMaterialTextures(std::vector<Texture>& textures, const filesystem::path& dirPath,
-                          const aiMaterial* mat, const aiTextureType type,
-                          const TextureType textureType) {
-	static std::unordered_map<filesystem::path, Texture> textureCache{};
+#include <assimp/DefaultIOSystem.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <format>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// Textures being decoded, until they're uploaded and handed to the resource manager. Import
+// threads start decodes and the main thread uploads them, so it's only touched with
+// textureDecodesMutex held.
+static std::mutex textureDecodesMutex;
+static std::unordered_map<filesystem::path, std::shared_future<MipChain>> textureDecodes{};
+
+void decodeTextures(const std::vector<TexturePath>& paths) {
+	std::lock_guard lock{textureDecodesMutex};
+	for (const TexturePath& path : paths) {
+		if (textureDecodes.contains(path.path) or getResources().contains(path.path.string()))
+			continue;
+		// specular maps are intensities, not colors, so they're filtered as they are
+		bool color = path.type == TextureType::textureDiffuse;
+		auto decode = [file = path.path, color] {
+			return getStartupReport().time("texture decode", file.string(),
+			                               [&] { return loadMipChain(file, color); });
+		};
+		textureDecodes[path.path] = getThreadPool().submit(decode).share();
+	}
+}
+
+bool texturesReady(const std::vector<TexturePath>& paths) {
+	// anything freed since it was asked for needs decoding again
+	decodeTextures(paths);
+
+	std::lock_guard lock{textureDecodesMutex};
+	for (const TexturePath& path : paths) {
+		auto decoding = textureDecodes.find(path.path);
+		if (decoding == textureDecodes.end()) continue; // already uploaded
+		if (decoding->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return false;
+	}
+	return true;
+}
+
+std::vector<Texture> loadTextures(const std::vector<TexturePath>& paths) {
+	decodeTextures(paths);
+
+	std::vector<Texture> textures;
+	for (const TexturePath& path : paths) {
+		const std::string key = path.path.string();
+		std::shared_ptr<GpuTexture> handle = getResources().find<GpuTexture>(key);
+		if (not handle) {
+			std::shared_future<MipChain> decoding;
+			{
+				std::lock_guard lock{textureDecodesMutex};
+				decoding = textureDecodes.at(path.path);
+			}
+
+			// the decode doesn't need the lock, and this is the only thread that uploads
+			// rethrows anything the decode threw
+			// only the smallest levels go in now, and the rest stream in over the next frames
+			StartupReport::Phase upload = getStartupReport().begin("texture upload", key);
+			handle = getTextureStreamer().upload(decoding);
+			upload.end();
+			getResources().add(ResourceKind::texture, key, handle, handle->getBytes());
+
+			// added before it's erased, so decodeTextures always finds it in one place or the other
+			std::lock_guard lock{textureDecodesMutex};
+			textureDecodes.erase(path.path);
+		}
+		textures.push_back({handle, path.type});
+	}
+	return textures;
+}
+
+// adds the paths of mat's textures of one type to paths
+static void materialTexturePaths(std::vector<TexturePath>& paths, const filesystem::path& dirPath,
+                                 const aiMaterial* mat, const aiTextureType type,
+                                 const TextureType textureType) {
 	for (uint i = 0; i < mat->GetTextureCount(type); i++) {
 		aiString aiPath;
 		mat->GetTexture(type, i, &aiPath);
 		filesystem::path asFsPath{std::string(aiPath.C_Str())};
-		filesystem::path fullPath = dirPath / asFsPath;
-		Texture texture;
-
-		auto cachedTexture = textureCache.find(fullPath);
-		if (cachedTexture != textureCache.end()) { // already loaded
-			texture = cachedTexture->second;
-		} else { // load texture
-			texture.id = loadTexture(fullPath);
-			texture.type = textureType;
-			textureCache[fullPath] = texture;
-		}
-		textures.push_back(texture);
+		paths.push_back({dirPath / asFsPath, textureType});
+	}
+}
+
+// every texture a mesh with this material draws with
+static std::vector<TexturePath> materialTextures(const filesystem::path& dirPath,
+                                                 const aiMaterial* material) {
+	std::vector<TexturePath> paths;
+	materialTexturePaths(paths, dirPath, material, aiTextureType_DIFFUSE,
+	                     TextureType::textureDiffuse);
+	materialTexturePaths(paths, dirPath, material, aiTextureType_SPECULAR,
+	                     TextureType::textureSpecular);
+	return paths;
+}
+
+Model::Model(const filesystem::path& path, const Shaders::Object shader, const bool mergeMeshes,
+             const bool packVerticies, const double uploadBudget)
+    : BaseSceneGraphObject(glm::mat4(1)) {
+	this->modelPath = path;
+	this->shader = shader;
+	this->mergeMeshes = mergeMeshes;
+	this->packVerticies = packVerticies;
+	this->uploadBudget = uploadBudget;
+	this->nextUpload = 0;
+	this->loaded = false;
+	this->loadPhase = getStartupReport().begin("model load", path.string());
+
+	// only needs the path, so it's fine if the model is gone before it finishes
+	this->importing = getThreadPool().submit([path] {
+		return getStartupReport().time("model import", path.string(),
+		                               [&] { return importModel(path); });
+	});
+}
+
+static constexpr uint importFlags = aiProcess_Triangulate | aiProcess_FlipUVs
+                                  | aiProcess_JoinIdenticalVertices
+                                  | aiProcess_ValidateDataStructure | aiProcess_GenSmoothNormals;
+
+static constexpr std::array<char, 4> modelCacheMagic{'M', 'D', 'L', 'C'};
+
+// start of a model cache file, followed by dependencyCount dependencies, then the meshes
+struct ModelCacheHeader {
+	std::array<char, 4> magic;
+	uint version;
+	ulong key;
+	uint meshCount;
+	uint vertexSize; // catches TexVertex changing without a version bump
+	uint dependencyCount;
+	uint padding;
+};
+
+// A file the import read besides the model, like its .mtl, as it was when the cache was written.
+// Followed by the canonical path's bytes, padded to 8 so the next one is aligned.
+struct ModelCacheDependency {
+	ulong size;
+	long modified; // ticks of filesystem::last_write_time
+	ulong pathLength;
+};
+
+// a file's size and modification time, or nullopt if it's gone
+static std::optional<std::pair<ulong, long>> fileStamp(const filesystem::path& path) {
+	std::error_code error;
+	ulong size = filesystem::file_size(path, error);
+	if (error) return std::nullopt;
+	filesystem::file_time_type modified = filesystem::last_write_time(path, error);
+	if (error) return std::nullopt;
+	return std::pair{size, (long)modified.time_since_epoch().count()};
+}
+
+// remembers every file Assimp opens, so the cache can tell when any of them change
+class RecordingIOSystem : public Assimp::DefaultIOSystem {
+  public:
+	std::vector<filesystem::path> opened;
+
+	Assimp::IOStream* Open(const char* file, const char* mode = "rb") override {
+		Assimp::IOStream* stream = DefaultIOSystem::Open(file, mode);
+		if (stream) this->opened.push_back(file);
+		return stream;
 	}
+};
+
+// Each mesh is one of these, then textureCount texture paths, then its verticies, indicies and
+// levels of detail. Everything is padded to 4 bytes, so the indicies can be read straight from
+// the mapped file.
+struct ModelCacheMesh {
+	uint vertexCount;
+	uint indexCount;
+	uint lodCount;
+	uint textureCount;
+	float shininess;
+};
+
+// followed by the path's bytes
+struct ModelCacheTexture {
+	TextureType type;
+	uint pathLength;
+};
+
+static constexpr size_t padTo4(const size_t size) { return (size + 3) / 4 * 4; }
+static constexpr size_t padTo8(const size_t size) { return (size + 7) / 8 * 8; }
+
+// resolves what it can, so the same file reached different ways is the same path
+static filesystem::path canonicalPath(const filesystem::path& path) {
+	std::error_code error;
+	filesystem::path canonical = filesystem::weakly_canonical(path, error);
+	return error ? filesystem::absolute(path, error) : canonical;
 }
 
-void Model::loadModel(const filesystem::path& path) {
+ImportedModel Model::importModel(const filesystem::path& path, const bool withTextures) {
+	std::optional<filesystem::path> cacheFile;
+	ulong key = 0;
+	// texture paths are stored absolute, so the same file somewhere else needs its own cache
+	const filesystem::path modelPath = canonicalPath(path);
+	if (getCacheDir().has_value()) {
+		// a missing file is left for Assimp to complain about
+		std::optional<MappedFile> source = MappedFile::open(path);
+		if (source.has_value()) {
+			key = CacheKey()
+			          .add("model")
+			          .add(cacheVersion)
+			          .add(importFlags)
+			          .add(modelPath.string())
+			          .add(source->getData(), source->getSize())
+			          .get();
+			cacheFile = cachePath("models", key, "mesh");
+			std::optional<ImportedModel> cached = readCache(*cacheFile, key);
+			if (cached.has_value()) {
+				if (withTextures) {
+					for (const ImportedMesh& mesh : cached->meshes) decodeTextures(mesh.textures);
+				}
+				return std::move(*cached);
+			}
+		}
+	}
+
 	Assimp::Importer importer{};
-	const aiScene* scene = importer.ReadFile(
-	    path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices
-	              | aiProcess_ValidateDataStructure | aiProcess_GenSmoothNormals);
+	// the importer owns it, and it lives as long as the importer does
+	RecordingIOSystem* io = new RecordingIOSystem();
+	importer.SetIOHandler(io);
+	const aiScene* scene = importer.ReadFile(path, importFlags);
 	// check for errors
 	if (not scene or scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE or not scene->mRootNode) {
 		throw std::runtime_error(std::format("Failed to load model at {}: {}", path.string(),
 		                                     importer.GetErrorString()));
 	}
 
+	// start on the textures first, so they decode while the meshes are converted
+	if (withTextures) {
+		for (uint i = 0; i < scene->mNumMaterials; i++) {
+			decodeTextures(materialTextures(path.parent_path(), scene->mMaterials[i]));
+		}
+	}
+
 	// recursively process all nodes
-	processNode(scene->mRootNode, scene);
+	ImportedModel model;
+	processNode(scene->mRootNode, scene, path.parent_path(), model);
+
+	if (cacheFile.has_value()) {
+		// the model itself is already in the key
+		std::vector<filesystem::path> dependencies;
+		for (const filesystem::path& opened : io->opened) {
+			filesystem::path canonical = canonicalPath(opened);
+			if (canonical == modelPath) continue;
+			if (std::ranges::find(dependencies, canonical) == dependencies.end())
+				dependencies.push_back(canonical);
+		}
+		writeCache(*cacheFile, key, model, dependencies);
+	}
+	return model;
 }
 
-void Model::processNode(const aiNode* node, const aiScene* scene) {
+void Model::processNode(const aiNode* node, const aiScene* scene, const filesystem::path& dirPath,
+                        ImportedModel& model) {
 	// process this node's meshes
 	for (uint i = 0; i < node->mNumMeshes; i++) {
 		const aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		this->addChild(
-		    std::make_shared<Mesh<TexVertex, Shaders::Object>>(this->processMesh(mesh, scene)));
+		processMesh(mesh, scene, dirPath, model);
 	}
 
 	// recurse into child nodes
 	for (uint i = 0; i < node->mNumChildren; i++) {
-		this->processNode(node->mChildren[i], scene);
+		processNode(node->mChildren[i], scene, dirPath, model);
 	}
 }
 
-Mesh<TexVertex, Shaders::Object> Model::processMesh(const aiMesh* mesh, const aiScene* scene) {
+void Model::processMesh(const aiMesh* mesh, const aiScene* scene, const filesystem::path& dirPath,
+                        ImportedModel& model) {
 	std::vector<TexVertex> verticies;
 	std::vector<uint> indicies;
-	std::vector<Texture> textures;
-	float shininess = 0;
+	ImportedMesh imported{};
 
 	verticies.reserve(mesh->mNumVertices);
 	for (uint i = 0; i < mesh->mNumVertices; i++) {
@@ -74,6 +297,8 @@ Mesh<TexVertex, Shaders::Object> Model::processMesh(const aiMesh* mesh, const ai
 	}
 
 	// process indicies
+	// triangulated, so every face has 3
+	indicies.reserve(mesh->mNumFaces * 3);
 	for (uint i = 0; i < mesh->mNumFaces; i++) {
 		aiFace face = mesh->mFaces[i];
 		for (uint j = 0; j < face.mNumIndices; j++) {
@@ -82,15 +307,234 @@ Mesh<TexVertex, Shaders::Object> Model::processMesh(const aiMesh* mesh, const ai
 	}
 
 	// process material
+	// textures are uploaded on the main thread
 	if (mesh->mMaterialIndex >= 0) {
 		const aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-		loadMaterialTextures(textures, this->modelPath.parent_path(), material,
-		                     aiTextureType_DIFFUSE, TextureType::textureDiffuse);
-		loadMaterialTextures(textures, this->modelPath.parent_path(), material,
-		                     aiTextureType_SPECULAR, TextureType::textureSpecular);
-		auto statusCode = aiGetMaterialFloat(material, AI_MATKEY_SHININESS, &shininess);
-		if (statusCode != AI_SUCCESS) shininess = 32; // default value
+		imported.textures = materialTextures(dirPath, material);
+		auto statusCode = aiGetMaterialFloat(material, AI_MATKEY_SHININESS, &imported.shininess);
+		if (statusCode != AI_SUCCESS) imported.shininess = 32; // default value
+	}
+
+	// Assimp keeps the file's face order, which is rarely good for the GPU
+	imported.optimized = optimizeMesh(verticies, indicies);
+	imported.lods = buildMeshLods(verticies, indicies);
+
+	// moving the vectors in doesn't move their contents, so the spans stay valid
+	imported.verticies = verticies;
+	imported.indicies = indicies;
+	model.verticies.push_back(std::move(verticies));
+	model.indicies.push_back(std::move(indicies));
+	model.meshes.push_back(std::move(imported));
+}
+
+std::optional<ImportedModel> Model::readCache(const filesystem::path& cachePath, const ulong key) {
+	std::optional<MappedFile> file = MappedFile::open(cachePath);
+	if (not file.has_value()) return std::nullopt;
+
+	// hands out the file piece by piece, or null once it runs out
+	size_t offset = 0;
+	auto take = [&]<typename T>(const size_t count) -> const T* {
+		if (offset + count * sizeof(T) > file->getSize()) return nullptr;
+		const T* piece = reinterpret_cast<const T*>(file->getData() + offset);
+		offset += padTo4(count * sizeof(T));
+		return piece;
+	};
+
+	const ModelCacheHeader* header = take.operator()<ModelCacheHeader>(1);
+	if (not header or header->magic != modelCacheMagic or header->version != cacheVersion
+	    or header->key != key or header->vertexSize != sizeof(TexVertex))
+		return std::nullopt;
+
+	for (uint i = 0; i < header->dependencyCount; i++) {
+		const ModelCacheDependency* dependency = take.operator()<ModelCacheDependency>(1);
+		if (not dependency) return std::nullopt;
+		const char* path = take.operator()<char>(padTo8(dependency->pathLength));
+		if (not path) return std::nullopt;
+		std::optional<std::pair<ulong, long>> stamp =
+		    fileStamp(std::string(path, dependency->pathLength));
+		if (stamp != std::pair{dependency->size, dependency->modified}) return std::nullopt;
 	}
 
-	return Mesh(verticies, indicies, textures, shininess, this->shader);
+	ImportedModel model;
+	for (uint i = 0; i < header->meshCount; i++) {
+		const ModelCacheMesh* record = take.operator()<ModelCacheMesh>(1);
+		if (not record) return std::nullopt;
+
+		ImportedMesh mesh{};
+		mesh.shininess = record->shininess;
+		for (uint j = 0; j < record->textureCount; j++) {
+			const ModelCacheTexture* texture = take.operator()<ModelCacheTexture>(1);
+			if (not texture) return std::nullopt;
+			const char* path = take.operator()<char>(texture->pathLength);
+			if (not path) return std::nullopt;
+			mesh.textures.push_back({std::string(path, texture->pathLength), texture->type});
+		}
+
+		const TexVertex* verticies = take.operator()<TexVertex>(record->vertexCount);
+		const uint* indicies = take.operator()<uint>(record->indexCount);
+		const MeshLod* lods = take.operator()<MeshLod>(record->lodCount);
+		if (not verticies or not indicies or not lods) return std::nullopt;
+		mesh.verticies = {verticies, record->vertexCount};
+		mesh.indicies = {indicies, record->indexCount};
+		mesh.lods.assign(lods, lods + record->lodCount);
+		model.meshes.push_back(std::move(mesh));
+	}
+
+	// the meshes point into the mapping, so it has to live as long as they do
+	model.cacheFile = std::move(file);
+	return model;
+}
+
+void Model::writeCache(const filesystem::path& cachePath, const ulong key,
+                       const ImportedModel& model,
+                       const std::vector<filesystem::path>& dependencies) {
+	std::vector<std::byte> bytes;
+	auto append = [&](const void* data, const size_t size) {
+		const std::byte* begin = static_cast<const std::byte*>(data);
+		bytes.insert(bytes.end(), begin, begin + size);
+		bytes.resize(padTo4(bytes.size()));
+	};
+
+	const ModelCacheHeader header{modelCacheMagic,   cacheVersion, key, (uint)model.meshes.size(),
+	                              sizeof(TexVertex), (uint)dependencies.size(), 0};
+	append(&header, sizeof(header));
+	for (const filesystem::path& dependency : dependencies) {
+		std::optional<std::pair<ulong, long>> stamp = fileStamp(dependency);
+		// it changed while it was being read, so there's nothing to check it against
+		if (not stamp.has_value()) return;
+		std::string path = dependency.string();
+		const ModelCacheDependency record{stamp->first, stamp->second, path.size()};
+		append(&record, sizeof(record));
+		path.resize(padTo8(path.size()), '\0');
+		append(path.data(), path.size());
+	}
+	for (const ImportedMesh& mesh : model.meshes) {
+		const ModelCacheMesh record{(uint)mesh.verticies.size(), (uint)mesh.indicies.size(),
+		                            (uint)mesh.lods.size(), (uint)mesh.textures.size(),
+		                            mesh.shininess};
+		append(&record, sizeof(record));
+		for (const TexturePath& texture : mesh.textures) {
+			std::string path = texture.path.string();
+			const ModelCacheTexture textureRecord{texture.type, (uint)path.size()};
+			append(&textureRecord, sizeof(textureRecord));
+			append(path.data(), path.size());
+		}
+		append(mesh.verticies.data(), mesh.verticies.size_bytes());
+		append(mesh.indicies.data(), mesh.indicies.size_bytes());
+		append(mesh.lods.data(), VECTOR_SIZE_BYTES(mesh.lods));
+	}
+
+	writeCacheFile(cachePath, {bytes});
+}
+
+// Finds the mesh if it's still resident from an earlier load, or uploads it as Vertex and Index.
+// imported is converted to them if it isn't already. Returns a new instance of it either way.
+template <typename Vertex, typename Index>
+static std::shared_ptr<BaseSceneGraphNode>
+residentMesh(const std::string& key, const ImportedMesh& imported, const Shaders::Object shader) {
+	typedef Mesh<Vertex, Shaders::Object, Index> ModelMesh;
+	std::shared_ptr<ModelMesh> mesh = getResources().find<ModelMesh>(key);
+	if (mesh) return std::make_shared<MeshInstance<ModelMesh>>(mesh);
+
+	// straight from the import, which may be the mapped cache file, unless it needs converting
+	std::vector<ushort> shortIndicies;
+	std::span<const Index> indicies;
+	if constexpr (std::is_same_v<Index, ushort>) {
+		shortIndicies.assign(ALL_OF(imported.indicies));
+		indicies = shortIndicies;
+	} else {
+		indicies = imported.indicies;
+	}
+
+	std::vector<Texture> textures = loadTextures(imported.textures);
+	if constexpr (std::is_same_v<Vertex, PackedTexVertex>) {
+		PackedTexVerticies packed = packTexVerticies(imported.verticies);
+		mesh = std::make_shared<ModelMesh>(packed.verticies, indicies, textures,
+		                                   imported.shininess, shader, imported.lods,
+		                                   packed.dequantize);
+	} else {
+		mesh = std::make_shared<ModelMesh>(imported.verticies, indicies, textures,
+		                                   imported.shininess, shader, imported.lods);
+	}
+	getResources().add(ResourceKind::mesh, key, mesh, mesh->gpuBytes());
+	return std::make_shared<MeshInstance<ModelMesh>>(mesh);
+}
+
+bool Model::uploadMeshes() {
+	// always upload at least one mesh, so a mesh that takes longer than the budget can't stall
+	// loading forever
+	auto start = std::chrono::steady_clock::now();
+	const std::vector<ImportedMesh>& meshes = this->toUpload.meshes;
+	while (this->nextUpload < meshes.size()) {
+		const ImportedMesh& imported = meshes[this->nextUpload];
+		const std::string key = std::format("{}#{}{}", this->modelPath.string(), this->nextUpload,
+		                                    this->packVerticies ? "#packed" : "");
+		// uploading is quick, but waiting for a decode isn't, so check back next frame
+		if (not getResources().contains(key) and not texturesReady(imported.textures))
+			return false;
+
+		std::shared_ptr<BaseSceneGraphNode> mesh;
+		bool shortIndicies = imported.verticies.size() <= 65536;
+		if (this->packVerticies) {
+			mesh = shortIndicies
+			         ? residentMesh<PackedTexVertex, ushort>(key, imported, this->shader)
+			         : residentMesh<PackedTexVertex, uint>(key, imported, this->shader);
+		} else {
+			mesh = shortIndicies ? residentMesh<TexVertex, ushort>(key, imported, this->shader)
+			                     : residentMesh<TexVertex, uint>(key, imported, this->shader);
+		}
+		this->nextUpload++;
+		this->uploaded.push_back(mesh);
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() >= this->uploadBudget) break;
+	}
+	if (this->nextUpload < meshes.size()) return false;
+
+	// everything shows up on the same frame
+	for (auto& mesh : this->uploaded) this->addChild(mesh);
+	this->uploaded.clear();
+	return true;
+}
+
+bool Model::uploadBatch() {
+	// still there if this model was loaded before, and nothing needed the memory since
+	const std::string key = std::format("{}#batch", this->modelPath.string());
+	std::shared_ptr<MeshBatch> batch = getResources().find<MeshBatch>(key);
+	if (not batch) {
+		const std::vector<ImportedMesh>& meshes = this->toUpload.meshes;
+		// the batch is all or nothing, so every texture has to be ready first
+		for (const ImportedMesh& mesh : meshes) {
+			if (not texturesReady(mesh.textures)) return false;
+		}
+
+		std::vector<BatchedMesh> batched;
+		batched.reserve(meshes.size());
+		for (const ImportedMesh& mesh : meshes) {
+			batched.push_back({mesh.verticies, mesh.indicies, mesh.lods,
+			                   loadTextures(mesh.textures), mesh.shininess});
+		}
+		batch = std::make_shared<MeshBatch>(batched, this->shader);
+		getResources().add(ResourceKind::mesh, key, batch, batch->gpuBytes());
+	}
+	this->addChild(std::make_shared<MeshInstance<MeshBatch>>(batch));
+	return true;
+}
+
+void Model::continueLoading() {
+	if (this->importing.valid()) {
+		if (this->importing.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+		// rethrows anything the import threw
+		this->toUpload = this->importing.get();
+		this->uploadPhase = getStartupReport().begin("model upload", this->modelPath.string());
+	}
+
+	bool done = this->mergeMeshes ? this->uploadBatch() : this->uploadMeshes();
+	if (not done) return;
+
+	// unmaps the cache file, if it came from one
+	this->toUpload = {};
+	this->loaded = true;
+	this->uploadPhase.end();
+	this->loadPhase.end();
 }
@@ -2,50 +2,141 @@
 #define MODEL_HPP
 
 #include "common.hpp"
+#include "diskCache.hpp"
 #include "mesh.hpp"
+#include "meshBatch.hpp"
+#include "meshOptimizer.hpp"
 #include "object.hpp"
 #include "sceneObject.hpp"
 #include "shaders.hpp"
+#include "startupReport.hpp"
 
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
 #include <filesystem>
+#include <future>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
 
-// adds to the passed in textures vector
-void loadMaterialTextures(std::vector<Texture>& textures, const filesystem::path& dirPath,
-                          const aiMaterial* mat, const aiTextureType type,
-                          const TextureType textureType);
+// a texture a mesh wants, before it's been loaded
+struct TexturePath {
+	filesystem::path path;
+	TextureType type;
+};
+
+// A mesh read from a model file, but not uploaded yet. Made on a worker thread, so it doesn't
+// hold anything from OpenGL. Its verticies and indicies belong to the ImportedModel it's in.
+struct ImportedMesh {
+	std::span<const TexVertex> verticies;
+	std::span<const uint> indicies; // every level of detail's, one after another
+	std::vector<MeshLod> lods;
+	std::vector<TexturePath> textures;
+	float shininess;
+	// how optimizeMesh changed it, or nullopt if it came from the cache
+	std::optional<MeshOptimizeStats> optimized;
+};
+
+// Every mesh from a model file, and the memory their verticies and indicies are in. That's either
+// a memory mapped cache file, or vectors converted from what Assimp imported.
+struct ImportedModel {
+	std::vector<ImportedMesh> meshes;
+	std::optional<MappedFile> cacheFile;
+	std::vector<std::vector<TexVertex>> verticies;
+	std::vector<std::vector<uint>> indicies;
+};
+
+// Starts decoding each texture on the thread pool, unless it already has been. Any thread can
+// call it, and a path asked for twice is only decoded once.
+void decodeTextures(const std::vector<TexturePath>& paths);
+
+// whether loadTextures can upload every one of paths without waiting for a decode
+bool texturesReady(const std::vector<TexturePath>& paths);
 
+// Uploads each texture, or reuses it if it's been uploaded before. Waits for any that are still
+// decoding. Only their smallest levels are uploaded right away, and the texture streamer fills in
+// the rest over the next frames. Needs the GL context, so only call it from the main thread.
+std::vector<Texture> loadTextures(const std::vector<TexturePath>& paths);
+
+// Loads in the background. The file is imported and converted, and its textures decoded, on the
+// thread pool. Then render() uploads the meshes a few at a time so no frame takes much longer than
+// uploadBudget. Nothing is drawn until every mesh is uploaded.
+// With mergeMeshes, every mesh goes into one MeshBatch instead, uploaded all at once.
+// packVerticies uploads separate meshes as PackedTexVertex, at half the size. Either way, meshes
+// with few enough vertices get 16 bit indicies.
 class Model : public BaseSceneGraphObject {
   private:
 	filesystem::path modelPath;
 	Shaders::Object shader;
+	bool mergeMeshes;
+	bool packVerticies;
+	double uploadBudget; // in seconds per frame
+
+	std::future<ImportedModel> importing; // valid until the import finishes
+	ImportedModel toUpload;
+	size_t nextUpload;
+	// instances of the uploaded meshes, since other models of the same file share the meshes
+	std::vector<std::shared_ptr<BaseSceneGraphNode>> uploaded;
+	bool loaded;
+	// the whole load, and from the import finishing to the last upload
+	StartupReport::Phase loadPhase, uploadPhase;
 
-	void loadModel(const filesystem::path& path);
+	// these run on a worker thread, so they can't touch OpenGL
+	static void processNode(const aiNode* node, const aiScene* scene,
+	                        const filesystem::path& dirPath, ImportedModel& model);
+	static void processMesh(const aiMesh* mesh, const aiScene* scene,
+	                        const filesystem::path& dirPath, ImportedModel& model);
 
-	void processNode(const aiNode* node, const aiScene* scene);
+	// nullopt if the cache file doesn't exist or doesn't match, including when any file the
+	// import read besides the model, like its .mtl, has changed since
+	static std::optional<ImportedModel> readCache(const filesystem::path& cachePath,
+	                                              const ulong key);
+	// dependencies are the other files the import read
+	static void writeCache(const filesystem::path& cachePath, const ulong key,
+	                       const ImportedModel& model,
+	                       const std::vector<filesystem::path>& dependencies);
 
-	Mesh<TexVertex, Shaders::Object> processMesh(const aiMesh* mesh, const aiScene* scene);
+	// uploads meshes until this frame's budget runs out, and adds them as children once they're
+	// all done
+	void continueLoading();
+	// These upload what they can this frame, and return whether they're done. uploadMeshes makes a
+	// Mesh per imported mesh, and uploadBatch makes one MeshBatch once every texture is decoded.
+	bool uploadMeshes();
+	bool uploadBatch();
 
   public:
-	Model(const filesystem::path& path, const Shaders::Object shader)
-	    : BaseSceneGraphObject(glm::mat4(1)) {
-		this->modelPath = path;
-		this->shader = shader;
-		this->loadModel(path);
-	}
+	// Bump whenever a change makes the import produce different meshes, or changes the cache
+	// file's layout, so old caches are ignored.
+	static constexpr uint cacheVersion = 4;
+
+	// Imports with Assimp, or memory maps the mesh cache if there's a matching one. Writes the
+	// cache after importing with Assimp. Doesn't touch OpenGL, so any thread can call it.
+	// The cache is checked against the model file and where it is, and every other file Assimp
+	// read for it, like material libraries. Textures are only referenced by path, so it doesn't
+	// depend on their contents.
+	// withTextures starts decoding the textures as soon as their paths are known.
+	static ImportedModel importModel(const filesystem::path& path, const bool withTextures = true);
+
+	Model(const filesystem::path& path, const Shaders::Object shader,
+	      const bool mergeMeshes = false, const bool packVerticies = false,
+	      const double uploadBudget = 0.004);
 
 	// meshes do the actual drawing
 	virtual void render(const Camera& camera [[maybe_unused]],
-	                    const SceneCascade& cascade [[maybe_unused]]) {}
+	                    const SceneCascade& cascade [[maybe_unused]]) {
+		if (not this->loaded) this->continueLoading();
+	}
 
 	virtual void print(const SceneCascade& cascade) {
-		std::println("{}Model: {}", std::string(SCENE_GRAPH_INDENT * cascade.recurseDepth, ' '),
-		             this->modelPath.string());
+		std::println("{}Model: {}{}", std::string(SCENE_GRAPH_INDENT * cascade.recurseDepth, ' '),
+		             this->modelPath.string(), this->loaded ? "" : " (loading)");
 	}
 
+	bool isLoaded() const { return this->loaded; }
+
 	virtual ~Model() = default;
 };
 
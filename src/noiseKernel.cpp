@@ -0,0 +1,349 @@
+#include "noiseKernel.hpp"
+
+#include <magic_enum/magic_enum.hpp>
+
+#include <cmath>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__x86_64__) or defined(__i386__)
+	#define NOISE_KERNEL_X86 1
+	#include <immintrin.h>
+#else
+	#define NOISE_KERNEL_X86 0
+#endif
+
+// The gradient vectors siv's Grad() picks from with a 4 bit hash, with z always 0 for 2d noise.
+// Grad returns (h & 1 ? -u : u) + (h & 2 ? -v : v) with u = h < 8 ? x : y and
+// v = h < 4 ? y : (h == 12 or h == 14 ? x : z).
+static constexpr std::array<float, 16> makeGradients(const bool xAxis) {
+	std::array<float, 16> gradients{};
+	for (uint h = 0; h < 16; h++) {
+		float uSign = (h & 1) ? -1 : 1;
+		float vSign = (h & 2) ? -1 : 1;
+		bool uIsX = h < 8;
+		bool vIsX = h >= 4 and (h == 12 or h == 14);
+		bool vIsY = h < 4;
+		if (xAxis) gradients[h] = (uIsX ? uSign : 0) + (vIsX ? vSign : 0);
+		else gradients[h] = (uIsX ? 0 : uSign) + (vIsY ? vSign : 0);
+	}
+	return gradients;
+}
+
+alignas(32) static constexpr std::array<float, 16> gradientTableX = makeGradients(true);
+alignas(32) static constexpr std::array<float, 16> gradientTableY = makeGradients(false);
+
+// 6t^5 - 15t^4 + 10t^3
+static inline float fade(const float t) { return t * t * t * (t * (t * 6 - 15) + 10); }
+
+// derivative of fade
+static inline float fadeDerivative(const float t) { return 30 * t * t * (t * (t - 2) + 1); }
+
+// values that are shared by a whole row
+struct RowConstants {
+	int iy;
+	float fy;
+	float v;
+	float dv;
+
+	RowConstants(const float y) {
+		float floorY = std::floor(y);
+		this->iy = static_cast<int32_t>(floorY) & 255;
+		this->fy = y - floorY;
+		this->v = fade(this->fy);
+		this->dv = fadeDerivative(this->fy);
+	}
+};
+
+// the backends need to read the permutation
+struct NoiseKernelImpl {
+	static void rowScalar(const NoiseKernel& kernel, const float xScale, const int xStart,
+	                      const float y, const uint count, float* values, float* gradientsX,
+	                      float* gradientsY);
+#if NOISE_KERNEL_X86
+	static void rowSse41(const NoiseKernel& kernel, const float xScale, const int xStart,
+	                     const float y, const uint count, float* values, float* gradientsX,
+	                     float* gradientsY);
+	static void rowAvx2(const NoiseKernel& kernel, const float xScale, const int xStart,
+	                    const float y, const uint count, float* values, float* gradientsX,
+	                    float* gradientsY);
+#endif
+};
+
+void NoiseKernelImpl::rowScalar(const NoiseKernel& kernel, const float xScale, const int xStart,
+                                const float y, const uint count, float* values, float* gradientsX,
+                                float* gradientsY) {
+	const int32_t* perm = kernel.permutation.data();
+	const RowConstants row{y};
+
+	for (uint i = 0; i < count; i++) {
+		float x = static_cast<float>(xStart + (int)i) * xScale;
+		float floorX = std::floor(x);
+		int ix = static_cast<int32_t>(floorX) & 255;
+		float fx = x - floorX;
+		float u = fade(fx);
+		float du = fadeDerivative(fx);
+
+		// hashes for each corner of the cell
+		int a = perm[ix] + row.iy;
+		int b = perm[ix + 1] + row.iy;
+		int h00 = perm[perm[a]] & 15;
+		int h10 = perm[perm[b]] & 15;
+		int h01 = perm[perm[a + 1]] & 15;
+		int h11 = perm[perm[b + 1]] & 15;
+
+		float gx00 = gradientTableX[h00], gy00 = gradientTableY[h00];
+		float gx10 = gradientTableX[h10], gy10 = gradientTableY[h10];
+		float gx01 = gradientTableX[h01], gy01 = gradientTableY[h01];
+		float gx11 = gradientTableX[h11], gy11 = gradientTableY[h11];
+
+		// dot products of each corner's gradient and the offset from it
+		float p00 = gx00 * fx + gy00 * row.fy;
+		float p10 = gx10 * (fx - 1) + gy10 * row.fy;
+		float p01 = gx01 * fx + gy01 * (row.fy - 1);
+		float p11 = gx11 * (fx - 1) + gy11 * (row.fy - 1);
+
+		float q0 = p00 + (p10 - p00) * u;
+		float q1 = p01 + (p11 - p01) * u;
+		float noise = q0 + (q1 - q0) * row.v;
+
+		// product rule over the lerps
+		float dq0x = gx00 + (gx10 - gx00) * u + (p10 - p00) * du;
+		float dq1x = gx01 + (gx11 - gx01) * u + (p11 - p01) * du;
+		float dq0y = gy00 + (gy10 - gy00) * u;
+		float dq1y = gy01 + (gy11 - gy01) * u;
+		float dx = dq0x + (dq1x - dq0x) * row.v;
+		float dy = dq0y + (dq1y - dq0y) * row.v + (q1 - q0) * row.dv;
+
+		// remap -1..1 to 0..1
+		values[i] = noise * 0.5f + 0.5f;
+		gradientsX[i] = dx * 0.5f;
+		gradientsY[i] = dy * 0.5f;
+	}
+}
+
+#if NOISE_KERNEL_X86
+
+__attribute__((target("sse4.1"))) void
+NoiseKernelImpl::rowSse41(const NoiseKernel& kernel, const float xScale, const int xStart,
+                          const float y, const uint count, float* values, float* gradientsX,
+                          float* gradientsY) {
+	const int32_t* perm = kernel.permutation.data();
+	const RowConstants row{y};
+
+	const __m128 one = _mm_set1_ps(1);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 scale = _mm_set1_ps(xScale);
+	const __m128 fy = _mm_set1_ps(row.fy);
+	const __m128 fyMinus1 = _mm_set1_ps(row.fy - 1);
+	const __m128 v = _mm_set1_ps(row.v);
+	const __m128 dv = _mm_set1_ps(row.dv);
+	const __m128i laneOffsets = _mm_setr_epi32(0, 1, 2, 3);
+
+	uint i = 0;
+	// 4 lanes at a time
+	for (; i + 4 <= count; i += 4) {
+		__m128i xIndex = _mm_add_epi32(_mm_set1_epi32(xStart + (int)i), laneOffsets);
+		__m128 x = _mm_mul_ps(_mm_cvtepi32_ps(xIndex), scale);
+		__m128 floorX = _mm_floor_ps(x);
+		__m128 fx = _mm_sub_ps(x, floorX);
+		__m128 fxMinus1 = _mm_sub_ps(fx, one);
+
+		// no gathers here, so look the gradients up one lane at a time
+		alignas(16) int32_t ix[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(ix),
+		                _mm_and_si128(_mm_cvttps_epi32(floorX), _mm_set1_epi32(255)));
+		alignas(16) float gx[4][4]; // [corner][lane]
+		alignas(16) float gy[4][4];
+		for (uint lane = 0; lane < 4; lane++) {
+			int a = perm[ix[lane]] + row.iy;
+			int b = perm[ix[lane] + 1] + row.iy;
+			int hashes[4] = {perm[perm[a]] & 15, perm[perm[b]] & 15, perm[perm[a + 1]] & 15,
+			                 perm[perm[b + 1]] & 15};
+			for (uint corner = 0; corner < 4; corner++) {
+				gx[corner][lane] = gradientTableX[hashes[corner]];
+				gy[corner][lane] = gradientTableY[hashes[corner]];
+			}
+		}
+		__m128 gx00 = _mm_load_ps(gx[0]), gx10 = _mm_load_ps(gx[1]);
+		__m128 gx01 = _mm_load_ps(gx[2]), gx11 = _mm_load_ps(gx[3]);
+		__m128 gy00 = _mm_load_ps(gy[0]), gy10 = _mm_load_ps(gy[1]);
+		__m128 gy01 = _mm_load_ps(gy[2]), gy11 = _mm_load_ps(gy[3]);
+
+		// fade and its derivative
+		__m128 u = _mm_mul_ps(_mm_mul_ps(fx, _mm_mul_ps(fx, fx)),
+		                      _mm_add_ps(_mm_mul_ps(fx, _mm_sub_ps(_mm_mul_ps(fx, _mm_set1_ps(6)),
+		                                                           _mm_set1_ps(15))),
+		                                 _mm_set1_ps(10)));
+		__m128 du = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(30), _mm_mul_ps(fx, fx)),
+		                       _mm_add_ps(_mm_mul_ps(fx, _mm_sub_ps(fx, _mm_set1_ps(2))), one));
+
+		__m128 p00 = _mm_add_ps(_mm_mul_ps(gx00, fx), _mm_mul_ps(gy00, fy));
+		__m128 p10 = _mm_add_ps(_mm_mul_ps(gx10, fxMinus1), _mm_mul_ps(gy10, fy));
+		__m128 p01 = _mm_add_ps(_mm_mul_ps(gx01, fx), _mm_mul_ps(gy01, fyMinus1));
+		__m128 p11 = _mm_add_ps(_mm_mul_ps(gx11, fxMinus1), _mm_mul_ps(gy11, fyMinus1));
+
+		__m128 d0 = _mm_sub_ps(p10, p00);
+		__m128 d1 = _mm_sub_ps(p11, p01);
+		__m128 q0 = _mm_add_ps(p00, _mm_mul_ps(d0, u));
+		__m128 q1 = _mm_add_ps(p01, _mm_mul_ps(d1, u));
+		__m128 noise = _mm_add_ps(q0, _mm_mul_ps(_mm_sub_ps(q1, q0), v));
+
+		__m128 dq0x = _mm_add_ps(_mm_add_ps(gx00, _mm_mul_ps(_mm_sub_ps(gx10, gx00), u)),
+		                         _mm_mul_ps(d0, du));
+		__m128 dq1x = _mm_add_ps(_mm_add_ps(gx01, _mm_mul_ps(_mm_sub_ps(gx11, gx01), u)),
+		                         _mm_mul_ps(d1, du));
+		__m128 dq0y = _mm_add_ps(gy00, _mm_mul_ps(_mm_sub_ps(gy10, gy00), u));
+		__m128 dq1y = _mm_add_ps(gy01, _mm_mul_ps(_mm_sub_ps(gy11, gy01), u));
+		__m128 dx = _mm_add_ps(dq0x, _mm_mul_ps(_mm_sub_ps(dq1x, dq0x), v));
+		__m128 dy = _mm_add_ps(_mm_add_ps(dq0y, _mm_mul_ps(_mm_sub_ps(dq1y, dq0y), v)),
+		                       _mm_mul_ps(_mm_sub_ps(q1, q0), dv));
+
+		_mm_storeu_ps(values + i, _mm_add_ps(_mm_mul_ps(noise, half), half));
+		_mm_storeu_ps(gradientsX + i, _mm_mul_ps(dx, half));
+		_mm_storeu_ps(gradientsY + i, _mm_mul_ps(dy, half));
+	}
+
+	// leftovers that don't fill a batch
+	rowScalar(kernel, xScale, xStart + (int)i, y, count - i, values + i, gradientsX + i,
+	          gradientsY + i);
+}
+
+__attribute__((target("avx2"))) void
+NoiseKernelImpl::rowAvx2(const NoiseKernel& kernel, const float xScale, const int xStart,
+                         const float y, const uint count, float* values, float* gradientsX,
+                         float* gradientsY) {
+	const int* perm = kernel.permutation.data();
+	const RowConstants row{y};
+
+	const __m256 one = _mm256_set1_ps(1);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 scale = _mm256_set1_ps(xScale);
+	const __m256 fy = _mm256_set1_ps(row.fy);
+	const __m256 fyMinus1 = _mm256_set1_ps(row.fy - 1);
+	const __m256 v = _mm256_set1_ps(row.v);
+	const __m256 dv = _mm256_set1_ps(row.dv);
+	const __m256i iy = _mm256_set1_epi32(row.iy);
+	const __m256i oneInt = _mm256_set1_epi32(1);
+	const __m256i hashMask = _mm256_set1_epi32(15);
+	const __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	uint i = 0;
+	for (; i + NoiseKernel::batchSize <= count; i += NoiseKernel::batchSize) {
+		__m256i xIndex = _mm256_add_epi32(_mm256_set1_epi32(xStart + (int)i), laneOffsets);
+		__m256 x = _mm256_mul_ps(_mm256_cvtepi32_ps(xIndex), scale);
+		__m256 floorX = _mm256_floor_ps(x);
+		__m256i ix = _mm256_and_si256(_mm256_cvttps_epi32(floorX), _mm256_set1_epi32(255));
+		__m256 fx = _mm256_sub_ps(x, floorX);
+		__m256 fxMinus1 = _mm256_sub_ps(fx, one);
+
+		// hashes for each corner of the cell
+		__m256i a = _mm256_add_epi32(_mm256_i32gather_epi32(perm, ix, 4), iy);
+		__m256i b =
+		    _mm256_add_epi32(_mm256_i32gather_epi32(perm, _mm256_add_epi32(ix, oneInt), 4), iy);
+		__m256i aa = _mm256_i32gather_epi32(perm, a, 4);
+		__m256i ba = _mm256_i32gather_epi32(perm, b, 4);
+		__m256i ab = _mm256_i32gather_epi32(perm, _mm256_add_epi32(a, oneInt), 4);
+		__m256i bb = _mm256_i32gather_epi32(perm, _mm256_add_epi32(b, oneInt), 4);
+		__m256i h00 = _mm256_and_si256(_mm256_i32gather_epi32(perm, aa, 4), hashMask);
+		__m256i h10 = _mm256_and_si256(_mm256_i32gather_epi32(perm, ba, 4), hashMask);
+		__m256i h01 = _mm256_and_si256(_mm256_i32gather_epi32(perm, ab, 4), hashMask);
+		__m256i h11 = _mm256_and_si256(_mm256_i32gather_epi32(perm, bb, 4), hashMask);
+
+		__m256 gx00 = _mm256_i32gather_ps(gradientTableX.data(), h00, 4);
+		__m256 gx10 = _mm256_i32gather_ps(gradientTableX.data(), h10, 4);
+		__m256 gx01 = _mm256_i32gather_ps(gradientTableX.data(), h01, 4);
+		__m256 gx11 = _mm256_i32gather_ps(gradientTableX.data(), h11, 4);
+		__m256 gy00 = _mm256_i32gather_ps(gradientTableY.data(), h00, 4);
+		__m256 gy10 = _mm256_i32gather_ps(gradientTableY.data(), h10, 4);
+		__m256 gy01 = _mm256_i32gather_ps(gradientTableY.data(), h01, 4);
+		__m256 gy11 = _mm256_i32gather_ps(gradientTableY.data(), h11, 4);
+
+		// fade and its derivative
+		__m256 u = _mm256_mul_ps(
+		    _mm256_mul_ps(fx, _mm256_mul_ps(fx, fx)),
+		    _mm256_add_ps(
+		        _mm256_mul_ps(fx, _mm256_sub_ps(_mm256_mul_ps(fx, _mm256_set1_ps(6)),
+		                                        _mm256_set1_ps(15))),
+		        _mm256_set1_ps(10)));
+		__m256 du = _mm256_mul_ps(
+		    _mm256_mul_ps(_mm256_set1_ps(30), _mm256_mul_ps(fx, fx)),
+		    _mm256_add_ps(_mm256_mul_ps(fx, _mm256_sub_ps(fx, _mm256_set1_ps(2))), one));
+
+		__m256 p00 = _mm256_add_ps(_mm256_mul_ps(gx00, fx), _mm256_mul_ps(gy00, fy));
+		__m256 p10 = _mm256_add_ps(_mm256_mul_ps(gx10, fxMinus1), _mm256_mul_ps(gy10, fy));
+		__m256 p01 = _mm256_add_ps(_mm256_mul_ps(gx01, fx), _mm256_mul_ps(gy01, fyMinus1));
+		__m256 p11 = _mm256_add_ps(_mm256_mul_ps(gx11, fxMinus1), _mm256_mul_ps(gy11, fyMinus1));
+
+		__m256 d0 = _mm256_sub_ps(p10, p00);
+		__m256 d1 = _mm256_sub_ps(p11, p01);
+		__m256 q0 = _mm256_add_ps(p00, _mm256_mul_ps(d0, u));
+		__m256 q1 = _mm256_add_ps(p01, _mm256_mul_ps(d1, u));
+		__m256 noise = _mm256_add_ps(q0, _mm256_mul_ps(_mm256_sub_ps(q1, q0), v));
+
+		__m256 dq0x = _mm256_add_ps(gx00, _mm256_mul_ps(_mm256_sub_ps(gx10, gx00), u));
+		dq0x = _mm256_add_ps(dq0x, _mm256_mul_ps(d0, du));
+		__m256 dq1x = _mm256_add_ps(gx01, _mm256_mul_ps(_mm256_sub_ps(gx11, gx01), u));
+		dq1x = _mm256_add_ps(dq1x, _mm256_mul_ps(d1, du));
+		__m256 dq0y = _mm256_add_ps(gy00, _mm256_mul_ps(_mm256_sub_ps(gy10, gy00), u));
+		__m256 dq1y = _mm256_add_ps(gy01, _mm256_mul_ps(_mm256_sub_ps(gy11, gy01), u));
+		__m256 dx = _mm256_add_ps(dq0x, _mm256_mul_ps(_mm256_sub_ps(dq1x, dq0x), v));
+		__m256 dy =
+		    _mm256_add_ps(_mm256_add_ps(dq0y, _mm256_mul_ps(_mm256_sub_ps(dq1y, dq0y), v)),
+		                  _mm256_mul_ps(_mm256_sub_ps(q1, q0), dv));
+
+		_mm256_storeu_ps(values + i, _mm256_add_ps(_mm256_mul_ps(noise, half), half));
+		_mm256_storeu_ps(gradientsX + i, _mm256_mul_ps(dx, half));
+		_mm256_storeu_ps(gradientsY + i, _mm256_mul_ps(dy, half));
+	}
+
+	// leftovers that don't fill a batch
+	rowScalar(kernel, xScale, xStart + (int)i, y, count - i, values + i, gradientsX + i,
+	          gradientsY + i);
+}
+
+#endif
+
+NoiseKernel::NoiseKernel(const siv::PerlinNoise& noise, const NoiseBackend backend) {
+	if (not isSupported(backend))
+		throw std::runtime_error(std::format("Noise backend {} isn't supported on this CPU.",
+		                                     magic_enum::enum_name(backend)));
+
+	const siv::PerlinNoise::state_type& state = noise.serialize();
+	for (uint i = 0; i < this->permutation.size(); i++) {
+		this->permutation[i] = state[i % state.size()];
+	}
+
+	this->backend = backend;
+	switch (backend) {
+	case NoiseBackend::scalar: this->rowFunc = NoiseKernelImpl::rowScalar; break;
+#if NOISE_KERNEL_X86
+	case NoiseBackend::sse41: this->rowFunc = NoiseKernelImpl::rowSse41; break;
+	case NoiseBackend::avx2: this->rowFunc = NoiseKernelImpl::rowAvx2; break;
+#else
+	case NoiseBackend::sse41:
+	case NoiseBackend::avx2: std::unreachable(); // isSupported would have thrown
+#endif
+	}
+}
+
+bool NoiseKernel::isSupported(const NoiseBackend backend) {
+	switch (backend) {
+	case NoiseBackend::scalar: return true;
+#if NOISE_KERNEL_X86
+	case NoiseBackend::sse41: return __builtin_cpu_supports("sse4.1");
+	case NoiseBackend::avx2: return __builtin_cpu_supports("avx2");
+#else
+	case NoiseBackend::sse41:
+	case NoiseBackend::avx2: return false;
+#endif
+	}
+	std::unreachable();
+}
+
+NoiseBackend NoiseKernel::bestBackend() {
+	if (isSupported(NoiseBackend::avx2)) return NoiseBackend::avx2;
+	if (isSupported(NoiseBackend::sse41)) return NoiseBackend::sse41;
+	return NoiseBackend::scalar;
+}
@@ -0,0 +1,55 @@
+#ifndef NOISEKERNEL_HPP
+#define NOISEKERNEL_HPP
+
+#include "common.hpp"
+
+#include <PerlinNoise.hpp>
+
+#include <array>
+#include <cstdint>
+
+// instruction sets NoiseKernel can use
+enum class NoiseBackend { scalar, sse41, avx2 };
+
+// Evaluates siv::PerlinNoise::noise2D_01 for a row of points at once, along with its analytic
+// gradient. Uses the same permutation as the siv::PerlinNoise it's built from, so the results match
+// to within float precision (siv uses doubles).
+class NoiseKernel {
+  public:
+	// how many samples the SIMD backends evaluate per step
+	static constexpr uint batchSize = 8;
+
+	// function that evaluates one row; see evaluateRow
+	typedef void (*RowFunc)(const NoiseKernel& kernel, const float xScale, const int xStart,
+	                        const float y, const uint count, float* values, float* gradientsX,
+	                        float* gradientsY);
+
+  private:
+	// doubled so lookups of (perm[i] + j) + 1 never need wrapping
+	alignas(32) std::array<int32_t, 512> permutation;
+	NoiseBackend backend;
+	RowFunc rowFunc;
+
+	friend struct NoiseKernelImpl;
+
+  public:
+	NoiseKernel(const siv::PerlinNoise& noise, const NoiseBackend backend);
+
+	// picks the fastest backend this CPU supports
+	NoiseKernel(const siv::PerlinNoise& noise) : NoiseKernel(noise, bestBackend()) {}
+
+	static bool isSupported(const NoiseBackend backend);
+
+	static NoiseBackend bestBackend();
+
+	NoiseBackend getBackend() const { return this->backend; }
+
+	// Evaluates noise at (x, y) for x = (xStart + i) * xScale, i in [0, count). The gradient is of
+	// the 0..1 noise value with respect to x and y. All output arrays must hold count floats.
+	void evaluateRow(const float xScale, const int xStart, const float y, const uint count,
+	                 float* values, float* gradientsX, float* gradientsY) const {
+		this->rowFunc(*this, xScale, xStart, y, count, values, gradientsX, gradientsY);
+	}
+};
+
+#endif /* NOISEKERNEL_HPP */
@@ -0,0 +1,55 @@
+#include "resourceManager.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+GpuTexture::~GpuTexture() { glDeleteTextures(1, &this->id); }
+
+size_t ResourceManager::getTotalBytes() const {
+	std::lock_guard lock{this->mutex};
+	return std::accumulate(ALL_OF(this->bytes), (size_t)0);
+}
+
+void ResourceManager::endFrame() {
+	std::vector<decltype(this->entries)::node_type> freed;
+	{
+		std::lock_guard lock{this->mutex};
+		this->frame++;
+
+		std::vector<decltype(this->entries)::iterator> unused;
+		for (auto it = this->entries.begin(); it != this->entries.end(); it++) {
+			// the manager's own reference is the only one left
+			if (it->second.resource.use_count() > 1) it->second.lastUsed = this->frame;
+			else unused.push_back(it);
+		}
+
+		size_t total = std::accumulate(ALL_OF(this->bytes), (size_t)0);
+		if (total <= this->budget) return;
+
+		std::ranges::sort(unused, {}, [](auto it) { return it->second.lastUsed; });
+		for (auto it : unused) {
+			if (total <= this->budget) break;
+			total -= it->second.bytes;
+			this->bytes[magic_enum::enum_integer(it->second.kind)] -= it->second.bytes;
+			freed.push_back(this->entries.extract(it));
+		}
+	}
+	// resources are destroyed here, outside the lock
+}
+
+void ResourceManager::clear() {
+	decltype(this->entries) entries;
+	{
+		std::lock_guard lock{this->mutex};
+		std::swap(entries, this->entries);
+		this->bytes.fill(0);
+	}
+}
+
+ResourceManager& getResources() {
+	static ResourceManager resources{(size_t)1024 * 1024 * 1024};
+	return resources;
+}
@@ -0,0 +1,135 @@
+#ifndef RESOURCEMANAGER_HPP
+#define RESOURCEMANAGER_HPP
+
+#include "common.hpp"
+
+#include <magic_enum/magic_enum.hpp>
+
+#include <array>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+
+// what a resource's GPU memory is counted as
+enum class ResourceKind { texture, mesh, program };
+
+// A texture object that's deleted along with the last handle to it. Can't be copied, since the
+// copy would delete the texture too.
+class GpuTexture {
+  private:
+	uint id;
+	size_t bytes;
+
+	GpuTexture(const GpuTexture&) = delete;
+	GpuTexture& operator=(const GpuTexture&) = delete;
+
+  public:
+	GpuTexture(const uint id, const size_t bytes) {
+		this->id = id;
+		this->bytes = bytes;
+	}
+
+	~GpuTexture();
+
+	uint getId() const { return this->id; }
+
+	size_t getBytes() const { return this->bytes; }
+};
+
+// Shares GPU resources by name, so nothing is loaded twice. Handles are shared_ptrs, so a
+// resource stays alive as long as anything holds one. Resources only the manager holds are kept
+// around in case they're wanted again, until usage goes over the budget. Then they're freed,
+// least recently used first.
+// Any thread can look resources up, but adding and freeing them needs the GL context, so that's
+// main thread only.
+class ResourceManager {
+  private:
+	struct Entry {
+		ResourceKind kind;
+		std::type_index type; // what resource really points to
+		std::shared_ptr<void> resource;
+		size_t bytes;
+		ulong lastUsed; // the last frame anything else held a handle
+	};
+
+	mutable std::mutex mutex;
+	std::unordered_map<std::string, Entry> entries;
+	std::array<size_t, magic_enum::enum_count<ResourceKind>()> bytes;
+	size_t budget;
+	ulong frame;
+
+	ResourceManager(const ResourceManager&) = delete;
+	ResourceManager& operator=(const ResourceManager&) = delete;
+
+  public:
+	ResourceManager(const size_t budget) {
+		this->bytes.fill(0);
+		this->budget = budget;
+		this->frame = 0;
+	}
+
+	// Starts managing resource under key. It's counted as bytes of kind until it's freed.
+	// Throws std::logic_error if key is taken.
+	template <typename T>
+	void add(const ResourceKind kind, const std::string& key, std::shared_ptr<T> resource,
+	         const size_t bytes) {
+		std::lock_guard lock{this->mutex};
+		if (this->entries.contains(key))
+			throw std::logic_error(std::format("There's already a resource named {}.", key));
+		this->entries.insert({key, {kind, typeid(T), std::move(resource), bytes, this->frame}});
+		this->bytes[magic_enum::enum_integer(kind)] += bytes;
+	}
+
+	// A handle to the resource named key, or null if there isn't one. Throws std::logic_error if
+	// it isn't a T.
+	template <typename T> std::shared_ptr<T> find(const std::string& key) {
+		std::lock_guard lock{this->mutex};
+		auto entry = this->entries.find(key);
+		if (entry == this->entries.end()) return nullptr;
+		if (entry->second.type != typeid(T))
+			throw std::logic_error(std::format("The resource named {} is a {}, not a {}.", key,
+			                                   entry->second.type.name(), typeid(T).name()));
+		entry->second.lastUsed = this->frame;
+		return std::static_pointer_cast<T>(entry->second.resource);
+	}
+
+	bool contains(const std::string& key) const {
+		std::lock_guard lock{this->mutex};
+		return this->entries.contains(key);
+	}
+
+	void setBudget(const size_t budget) {
+		std::lock_guard lock{this->mutex};
+		this->budget = budget;
+	}
+
+	size_t getBudget() const {
+		std::lock_guard lock{this->mutex};
+		return this->budget;
+	}
+
+	size_t getBytes(const ResourceKind kind) const {
+		std::lock_guard lock{this->mutex};
+		return this->bytes[magic_enum::enum_integer(kind)];
+	}
+
+	size_t getTotalBytes() const;
+
+	// Call once a frame. Marks every resource something holds a handle to as used, then frees
+	// unused ones, least recently used first, until usage is under the budget. Resources that are
+	// in use are never freed, so usage can stay over the budget if they need more than it.
+	void endFrame();
+
+	// Lets go of every resource. Anything still holding a handle keeps its resource alive, and
+	// frees it when it's done. Call this before the GL context is destroyed.
+	void clear();
+};
+
+// shared manager with a 1 GiB budget, created on first use
+ResourceManager& getResources();
+
+#endif /* RESOURCEMANAGER_HPP */
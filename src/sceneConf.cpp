@@ -1,10 +1,17 @@
 #include "sceneConf.hpp"
 
+#include "benchmarks.hpp"
 #include "genTerrain.hpp"
+#include "heightmapTerrain.hpp"
 #include "model.hpp"
+#include "startupReport.hpp"
+#include "terrainQuadtree.hpp"
+#include "terrainStreamer.hpp"
 
 #include <boost/program_options.hpp>
 
+#include <magic_enum/magic_enum.hpp>
+
 #include <iostream>
 
 std::shared_ptr<Config> parseArgs(const int argc, const char* const* const argv) {
@@ -14,7 +21,26 @@ std::shared_ptr<Config> parseArgs(const int argc, const char* const* const argv)
 	desc.add_options() //
 	    ("help", "Print help message") //
 	    ("no-models", "Don't load any models") //
-	    ("no-terrain", "Don't load any terrain"); //
+	    ("no-terrain", "Don't load any terrain") //
+	    ("terrain-normals", po::value<std::string>()->default_value("heightGrid"),
+	     "How terrain normals are calculated (heightGrid, perlinSamples or analytic)") //
+	    ("terrain-mode", po::value<std::string>()->default_value("fixed"),
+	     "How terrain is put in the scene (fixed, streaming, quadtree or heightmap)") //
+	    ("terrain-budget", po::value<uint>()->default_value(256),
+	     "GPU memory budget for streamed terrain, in MiB") //
+	    ("terrain-view-radius", po::value<uint>()->default_value(6),
+	     "How far to stream terrain, in chunks") //
+	    ("no-cache", "Don't read or write any on-disk caches") //
+	    ("compress-textures", "Block compress model textures (BC1, or BC3 with alpha)") //
+	    ("merge-meshes", "Put each model's meshes in one vertex and index buffer") //
+	    ("pack-verticies", "Quantize model verticies to half their size, unless they're merged") //
+	    ("gpu-budget", po::value<uint>()->default_value(1024),
+	     "GPU memory to keep unused textures and meshes in before freeing them, in MiB") //
+	    ("texture-upload", po::value<uint>()->default_value(8),
+	     "Texture data to stream to the GPU each frame, in MiB") //
+	    ("startup-report", po::value<std::string>(),
+	     "Write how long each part of startup took to this JSON file") //
+	    ("benchmark", po::value<std::string>(), "Run the named benchmark and exit"); //
 
 	po::variables_map vm;
 	po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -22,14 +48,52 @@ std::shared_ptr<Config> parseArgs(const int argc, const char* const* const argv)
 
 	if (vm.count("help")) {
 		std::cout << desc << "\n";
+		std::cout << "Benchmarks:\n";
+		for (const auto& [name, benchmark] : getBenchmarks()) {
+			std::cout << "  " << name << ": " << benchmark.description << "\n";
+		}
 		return NULL;
 	}
 
 	Config conf = {
 	    .loadModels = !vm.count("no-models"),
 	    .loadTerrain = !vm.count("no-terrain"),
+	    .terrainNormals = NormalMethod::heightGrid,
+	    .terrainMode = TerrainMode::fixed,
+	    .terrainBudgetMiB = vm["terrain-budget"].as<uint>(),
+	    .terrainViewRadius = vm["terrain-view-radius"].as<uint>(),
+	    .useCache = !vm.count("no-cache"),
+	    .compressTextures = (bool)vm.count("compress-textures"),
+	    .mergeModelMeshes = (bool)vm.count("merge-meshes"),
+	    .packModelVerticies = (bool)vm.count("pack-verticies"),
+	    .gpuBudgetMiB = vm["gpu-budget"].as<uint>(),
+	    .textureUploadMiB = vm["texture-upload"].as<uint>(),
+	    .benchmark = {},
+	    .startupReport = {},
 	};
 
+	std::string normalsName = vm["terrain-normals"].as<std::string>();
+	auto normals = magic_enum::enum_cast<NormalMethod>(normalsName);
+	if (not normals.has_value())
+		throw std::invalid_argument(std::format("Unknown terrain normal method {}.", normalsName));
+	conf.terrainNormals = *normals;
+
+	std::string modeName = vm["terrain-mode"].as<std::string>();
+	auto mode = magic_enum::enum_cast<TerrainMode>(modeName);
+	if (not mode.has_value())
+		throw std::invalid_argument(std::format("Unknown terrain mode {}.", modeName));
+	conf.terrainMode = *mode;
+
+	if (vm.count("benchmark")) {
+		std::string name = vm["benchmark"].as<std::string>();
+		if (not getBenchmarks().contains(name))
+			throw std::invalid_argument(std::format("No benchmark named {}.", name));
+		conf.benchmark = name;
+	}
+
+	if (vm.count("startup-report"))
+		conf.startupReport = filesystem::path{vm["startup-report"].as<std::string>()};
+
 	return std::make_shared<Config>(conf);
 }
 
@@ -39,13 +103,11 @@ std::shared_ptr<SceneGraphRoot> initScene(const ShaderContainer shaders, const C
 	// MODELS
 
 	if (config.loadModels) {
-		std::print("Loading models... ");
-		std::fflush(stdout);
-
+		// these show up once they've loaded in the background
+		std::println("Loading models in the background.");
 		scene->addChild(std::shared_ptr<Model>(
-		    new Model{MEDIA_DIR "./backpack/backpack.obj", shaders.objShader}));
-
-		std::println("Done.");
+		    new Model{MEDIA_DIR "./backpack/backpack.obj", shaders.objShader,
+		              config.mergeModelMeshes, config.packModelVerticies}));
 	}
 
 	// TERRAIN
@@ -53,6 +115,8 @@ std::shared_ptr<SceneGraphRoot> initScene(const ShaderContainer shaders, const C
 	if (config.loadTerrain) {
 		std::print("Generating terrain... ");
 		std::fflush(stdout);
+		StartupReport::Phase phase = getStartupReport().begin(
+		    "terrain generation", std::string(magic_enum::enum_name(config.terrainMode)));
 		constexpr DSColor grass{
 		    glm::vec3(0.96, 0.84, 0.69),
 		    glm::vec3(0.96, 0.84, 0.69) / 16.f,
@@ -61,11 +125,44 @@ std::shared_ptr<SceneGraphRoot> initScene(const ShaderContainer shaders, const C
 		    glm::vec3(0.25, 0.60, 0.04),
 		    glm::vec3(0.25, 0.60, 0.04) / 4.f,
 		};
-		Terrain terrain{
-		    123'123, 32, grass, sand, glm::vec3(5, 5, 1), glm::ivec2(25), shaders.terrainShader};
-		terrain.setTransform(glm::translate(glm::identity<glm::mat4>(), {5, 0, 0}));
-		scene->addChild(std::make_shared<Terrain>(terrain));
-		std::println("Done.");
+		// all of these have the same sample spacing
+		switch (config.terrainMode) {
+		case TerrainMode::fixed: {
+			auto terrain = std::make_shared<Terrain>(123'123, 32, grass, sand, glm::vec3(5, 5, 1),
+			                                         glm::uvec2(25), config.terrainNormals,
+			                                         shaders.terrainShader);
+			terrain->setTransform(glm::translate(glm::identity<glm::mat4>(), {5, 0, 0}));
+			scene->addChild(terrain);
+			break;
+		}
+		case TerrainMode::streaming:
+			scene->addChild(std::make_shared<TerrainStreamer>(
+			    123'123, 32, grass, sand, glm::vec2(0.2), 1, 65, config.terrainNormals,
+			    config.terrainViewRadius, (size_t)config.terrainBudgetMiB * 1024 * 1024,
+			    shaders.terrainShader));
+			break;
+		case TerrainMode::quadtree: {
+			auto terrain = std::make_shared<TerrainQuadtree>(123'123, 32, grass, sand,
+			                                                 glm::vec2(0.2), 1, 33, 5,
+			                                                 config.terrainNormals, 2,
+			                                                 shaders.terrainShader);
+			// centered under the camera's starting position
+			glm::vec2 size = terrain->getSize();
+			terrain->setTransform(
+			    glm::translate(glm::identity<glm::mat4>(), {-size.x / 2, -1, -size.y / 2}));
+			scene->addChild(terrain);
+			break;
+		}
+		case TerrainMode::heightmap: {
+			auto terrain = std::make_shared<HeightmapTerrain>(123'123, 32, grass, sand,
+			                                                  glm::vec3(5, 5, 1), glm::ivec2(25),
+			                                                  shaders.terrainShader);
+			terrain->setTransform(glm::translate(glm::identity<glm::mat4>(), {5, 0, 0}));
+			scene->addChild(terrain);
+			break;
+		}
+		}
+		std::println("Done in {:.3f}s.", phase.end());
 	}
 
 	std::vector<SceneCascade> stack{};
@@ -1,12 +1,16 @@
 #ifndef SCENECONF_HPP
 #define SCENECONF_HPP
 
+#include "genTerrain.hpp"
 #include "lightCube.hpp"
 #include "object.hpp"
 #include "sceneObject.hpp"
 #include "terrain.hpp"
 
+#include <filesystem>
 #include <memory>
+#include <optional>
+#include <string>
 
 struct ShaderContainer {
 	Shaders::Object objShader;
@@ -14,9 +18,29 @@ struct ShaderContainer {
 	Shaders::LightCube lightShader;
 };
 
+// how terrain is put in the scene
+enum class TerrainMode {
+	fixed, // one small patch
+	streaming, // chunks around the camera
+	quadtree, // one large quadtree with level of detail
+	heightmap, // like fixed, but only the heights are uploaded
+};
+
 struct Config {
-	bool loadModels; // really slow, skipping makes init faster
+	bool loadModels; // loaded in the background, so they pop in after startup
 	bool loadTerrain;
+	NormalMethod terrainNormals;
+	TerrainMode terrainMode;
+	uint terrainBudgetMiB; // for streamed terrain
+	uint terrainViewRadius; // in chunks, for streamed terrain
+	bool useCache; // read and write the on-disk caches in CACHE_DIR
+	bool compressTextures; // BC1/BC3 model textures, if the GPU supports it
+	bool mergeModelMeshes; // draw each model from one MeshBatch instead of a Mesh per part
+	bool packModelVerticies; // PackedTexVertex for model meshes, unless they're merged
+	uint gpuBudgetMiB; // for textures, meshes and programs nothing is using any more
+	uint textureUploadMiB; // per frame, for streaming in texture levels
+	std::optional<std::string> benchmark; // run this benchmark instead of the scene
+	std::optional<filesystem::path> startupReport; // write how long startup took here, as JSON
 };
 
 // may return null to indicate the user only wanted help text, version, etc
@@ -1,7 +1,10 @@
 #include "sdlConfig.hpp"
 
+#include "startupReport.hpp"
+
 void SDLData::setup(const glm::uvec2 initSize) {
 	this->initSize = initSize;
+	StartupReport::Phase phase = getStartupReport().begin("sdl init");
 	CALL_SDL(SDL_Init(SDL_INIT_VIDEO));
 
 	CALL_SDL(SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1));
@@ -16,9 +19,13 @@ void SDLData::setup(const glm::uvec2 initSize) {
 	CALL_SDL(SDL_SetWindowResizable(window, true));
 	CALL_SDL(SDL_SetWindowRelativeMouseMode(window, true));
 
+	// ends the last phase
+	phase = getStartupReport().begin("gl context");
 	this->context = SDL_GL_CreateContext(window);
 
+	phase = getStartupReport().begin("glad load");
 	this->version = gladLoadGL((GLADloadfunc)SDL_GL_GetProcAddress);
+	phase.end();
 	std::println("GLAD version: {}", this->version);
 
 	glViewport(0, 0, this->initSize.x, this->initSize.y);
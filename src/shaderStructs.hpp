@@ -4,25 +4,29 @@
 // utilites for writing shader setters
 
 // for VAO attributes
-#define STRUCT_MEMBER_ATTRIB(attrNum, structName, member) \
+// components is how many values the member holds; glType is what each one is stored as
+#define STRUCT_MEMBER_ATTRIB_TYPED(attrNum, structName, member, components, glType, normalized) \
 	do { \
 		glEnableVertexAttribArray(attrNum); \
-		glVertexAttribPointer(attrNum, sizeof(structName::member) / sizeof(float), GL_FLOAT, \
-		                      GL_FALSE, sizeof(structName), (void*)offsetof(structName, member)); \
+		glVertexAttribPointer(attrNum, components, glType, normalized, sizeof(structName), \
+		                      (void*)offsetof(structName, member)); \
 	} while (false)
 
-// makes writing shader setters easier
-#define SET_UNIFORM_ATTR(attr) \
-	do { \
-		if (index == NOT_ARRAY) { \
-			shader.setUniform(uniformName + "." + #attr, value.attr); \
-		} else { \
-			shader.setUniform(uniformName + "[" + std::to_string(index) + "]." + #attr, \
-			                  value.attr); \
-		} \
-	} while (false)
+// for VAO attributes made of floats
+#define STRUCT_MEMBER_ATTRIB(attrNum, structName, member) \
+	STRUCT_MEMBER_ATTRIB_TYPED(attrNum, structName, member, \
+	                           sizeof(structName::member) / sizeof(float), GL_FLOAT, GL_FALSE)
+
+// for VAO attributes stored as integers that the shader sees as -1 to 1 (signed) or 0 to 1
+#define STRUCT_MEMBER_ATTRIB_NORMALIZED(attrNum, structName, member, components, glType) \
+	STRUCT_MEMBER_ATTRIB_TYPED(attrNum, structName, member, components, glType, GL_TRUE)
+
+// for VAO attributes packed with glm::packHalf2x16, components halves at a time
+#define STRUCT_MEMBER_ATTRIB_HALF(attrNum, structName, member, components) \
+	STRUCT_MEMBER_ATTRIB_TYPED(attrNum, structName, member, components, GL_HALF_FLOAT, GL_FALSE)
 
-// Specifies the value is not an array but a single value. For uniform setters.
-#define NOT_ARRAY -1
+// for normals packed with glm::packSnorm3x10_1x2
+#define STRUCT_MEMBER_ATTRIB_PACKED_NORMAL(attrNum, structName, member) \
+	STRUCT_MEMBER_ATTRIB_TYPED(attrNum, structName, member, 4, GL_INT_2_10_10_10_REV, GL_TRUE)
 
 #endif /* SHADERSTRUCTS_HPP */
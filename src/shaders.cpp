@@ -4,6 +4,7 @@
 #include "shaders.hpp"
 
 #include "common.hpp"
+#include "startupReport.hpp"
 
 #include <filesystem>
 #include <fstream>
@@ -35,11 +36,16 @@ ShaderProgram::ShaderProgram(const filesystem::path& vertexShaderPath,
 	std::string vertexShaderSrc = readFile(vertexShaderPath);
 	std::string fragmentShaderSrc = readFile(fragmentShaderPath);
 
+	// object.vert.glsl is object
+	std::string program = vertexShaderPath.filename().string();
+	program = program.substr(0, program.find('.'));
+	StartupReport::Phase phase = getStartupReport().begin("shader compile", program);
 	uint vertexShader =
 	    this->compileShader(vertexShaderSrc, vertexShaderPath, ShaderType::vertexShader);
 	uint fragmentShader =
 	    this->compileShader(fragmentShaderSrc, vertexShaderPath, ShaderType::fragmentShader);
 
+	phase = getStartupReport().begin("shader link", program);
 	this->shaderProgram = glCreateProgram();
 	glAttachShader(this->shaderProgram, vertexShader);
 	glAttachShader(this->shaderProgram, fragmentShader);
@@ -24,6 +24,7 @@
 
 #include <magic_enum/magic_enum.hpp>
 
+#include <array>
 #include <filesystem>
 #include <memory>
 #include <string>
@@ -38,8 +39,6 @@ class ShaderProgram : public std::enable_shared_from_this<ShaderProgram> {
 	uint compileShader(const std::string& source, const filesystem::path& path,
 	                   ShaderType shaderType);
 
-	std::unordered_map<std::string, int> locationCache;
-
 	// Copying would break the RAII-based cleanup system. In other words, incorectly calling the
 	// destructor would delete the underlying glShaderProgram too early.
 	ShaderProgram(const ShaderProgram&) = delete;
@@ -48,17 +47,15 @@ class ShaderProgram : public std::enable_shared_from_this<ShaderProgram> {
   protected:
 	uint shaderProgram;
 
-	// call glGetUniformLocation with a cache
-	// note: nothing is ever deleted from the cache, but if you have that many uniforms you have
-	// other, more pressing problems
-	int getUniformLocation(const std::string& name) {
-		if (this->locationCache.count(name) == 1) {
-			return this->locationCache[name];
-		} else {
-			int location = glGetUniformLocation(this->shaderProgram, name.c_str());
-			this->locationCache.insert({name, location});
-			return location;
+	// Looks up each of names once the program's linked. Any the compiler optimized out are -1,
+	// which OpenGL quietly ignores when they're set.
+	template <size_t Count>
+	std::array<int, Count> getUniformLocations(const std::array<const char*, Count>& names) const {
+		std::array<int, Count> locations;
+		for (size_t i = 0; i < Count; i++) {
+			locations[i] = glGetUniformLocation(this->shaderProgram, names[i]);
 		}
+		return locations;
 	}
 
 	// paths are loaded at runtime, so must be relative to the binary (or absolute)
@@ -67,80 +64,72 @@ class ShaderProgram : public std::enable_shared_from_this<ShaderProgram> {
 
 	~ShaderProgram() { glDeleteProgram(this->shaderProgram); }
 
-	void setUniform(const std::string& name, const bool value) {
-		glUniform1i(this->getUniformLocation(name), value);
-	}
+	void setUniform(const int location, const bool value) { glUniform1i(location, value); }
 
-	void setUniform(const std::string& name, const glm::bvec2 value) {
-		glUniform2i(this->getUniformLocation(name), value.x, value.y);
+	void setUniform(const int location, const glm::bvec2 value) {
+		glUniform2i(location, value.x, value.y);
 	}
 
-	void setUniform(const std::string& name, const glm::bvec3 value) {
-		glUniform3i(this->getUniformLocation(name), value.x, value.y, value.z);
+	void setUniform(const int location, const glm::bvec3 value) {
+		glUniform3i(location, value.x, value.y, value.z);
 	}
 
-	void setUniform(const std::string& name, const glm::bvec4 value) {
-		glUniform4i(this->getUniformLocation(name), value.x, value.y, value.z, value.w);
+	void setUniform(const int location, const glm::bvec4 value) {
+		glUniform4i(location, value.x, value.y, value.z, value.w);
 	}
 
-	void setUniform(const std::string& name, const int value) {
-		glUniform1i(this->getUniformLocation(name), value);
-	}
+	void setUniform(const int location, const int value) { glUniform1i(location, value); }
 
-	void setUniform(const std::string& name, const glm::ivec2 value) {
-		glUniform2i(this->getUniformLocation(name), value.x, value.y);
+	void setUniform(const int location, const glm::ivec2 value) {
+		glUniform2i(location, value.x, value.y);
 	}
 
-	void setUniform(const std::string& name, const glm::ivec3 value) {
-		glUniform3i(this->getUniformLocation(name), value.x, value.y, value.z);
+	void setUniform(const int location, const glm::ivec3 value) {
+		glUniform3i(location, value.x, value.y, value.z);
 	}
 
-	void setUniform(const std::string& name, const glm::ivec4 value) {
-		glUniform4i(this->getUniformLocation(name), value.x, value.y, value.z, value.w);
+	void setUniform(const int location, const glm::ivec4 value) {
+		glUniform4i(location, value.x, value.y, value.z, value.w);
 	}
 
-	void setUniform(const std::string& name, const uint value) {
-		glUniform1ui(this->getUniformLocation(name), value);
-	}
+	void setUniform(const int location, const uint value) { glUniform1ui(location, value); }
 
-	void setUniform(const std::string& name, const glm::uvec2 value) {
-		glUniform2ui(this->getUniformLocation(name), value.x, value.y);
+	void setUniform(const int location, const glm::uvec2 value) {
+		glUniform2ui(location, value.x, value.y);
 	}
 
-	void setUniform(const std::string& name, const glm::uvec3 value) {
-		glUniform3ui(this->getUniformLocation(name), value.x, value.y, value.z);
+	void setUniform(const int location, const glm::uvec3 value) {
+		glUniform3ui(location, value.x, value.y, value.z);
 	}
 
-	void setUniform(const std::string& name, const glm::uvec4 value) {
-		glUniform4ui(this->getUniformLocation(name), value.x, value.y, value.z, value.w);
+	void setUniform(const int location, const glm::uvec4 value) {
+		glUniform4ui(location, value.x, value.y, value.z, value.w);
 	}
 	
-	void setUniform(const std::string& name, const float value) {
-		glUniform1f(this->getUniformLocation(name), value);
-	}
+	void setUniform(const int location, const float value) { glUniform1f(location, value); }
 
-	void setUniform(const std::string& name, const glm::vec2 value) {
-		glUniform2f(this->getUniformLocation(name), value.x, value.y);
+	void setUniform(const int location, const glm::vec2 value) {
+		glUniform2f(location, value.x, value.y);
 	}
 
-	void setUniform(const std::string& name, const glm::vec3 value) {
-		glUniform3f(this->getUniformLocation(name), value.x, value.y, value.z);
+	void setUniform(const int location, const glm::vec3 value) {
+		glUniform3f(location, value.x, value.y, value.z);
 	}
 
-	void setUniform(const std::string& name, const glm::vec4 value) {
-		glUniform4f(this->getUniformLocation(name), value.x, value.y, value.z, value.w);
+	void setUniform(const int location, const glm::vec4 value) {
+		glUniform4f(location, value.x, value.y, value.z, value.w);
 	}
 
-	void setUniform(const std::string& name, const glm::mat2 value) {
-		glUniformMatrix2fv(this->getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+	void setUniform(const int location, const glm::mat2 value) {
+		glUniformMatrix2fv(location, 1, GL_FALSE, glm::value_ptr(value));
 	}
 
-	void setUniform(const std::string& name, const glm::mat3 value) {
-		glUniformMatrix3fv(this->getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+	void setUniform(const int location, const glm::mat3 value) {
+		glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
 	}
 
-	void setUniform(const std::string& name, const glm::mat4 value) {
-		glUniformMatrix4fv(this->getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+	void setUniform(const int location, const glm::mat4 value) {
+		glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
 	}
 
   public:
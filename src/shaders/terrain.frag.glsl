@@ -2,13 +2,21 @@
 #include "lighting.glsl"
 in vec3 fragPos;
 in vec3 inputNormal;
-in vec3 vertDiffuse;
-in vec3 vertSpecular;
+in float vertHeight; // before obj2world
 
 out vec4 fragColor;
 
+// contains a diffuse and specular component
+struct DSColor {
+	vec3 diffuse;
+	vec3 specular;
+};
+
 struct TerrMaterial {
 	float shininess; // specular exponent
+	DSColor bottomColor; // at a height of 0
+	DSColor topColor; // at maxHeight
+	float maxHeight;
 };
 
 #define POINT_LIGHT_COUNT 4
@@ -25,8 +33,10 @@ void main() {
 	vec3 normal = normalize(inputNormal);
 	vec3 viewDir = normalize(viewPos - fragPos);
 
-	vec3 diffVal = vertDiffuse;
-	vec3 specVal = vertSpecular;
+	// blending per fragment matches blending per vertex, since it's linear in height
+	float blend = vertHeight / material.maxHeight;
+	vec3 diffVal = mix(material.bottomColor.diffuse, material.topColor.diffuse, blend);
+	vec3 specVal = mix(material.bottomColor.specular, material.topColor.specular, blend);
 
 	// directional light
 	vec3 result = calcDirLight(dirLight, material.shininess, normal, viewDir, diffVal, specVal);
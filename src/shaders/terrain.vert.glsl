@@ -1,24 +1,60 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec3 aDiffuse;
-layout (location = 3) in vec3 aSpecular;
+// only used by quadtree terrain; where this vertex is in the next coarser level
+layout (location = 2) in vec3 aMorphPos;
+layout (location = 3) in vec3 aMorphNormal;
 
 out vec3 fragPos;
 out vec3 inputNormal; // it's an input for the fragment shader
-out vec3 vertDiffuse;
-out vec3 vertSpecular;
+out float vertHeight; // for picking colors
 
 uniform mat4 obj2world;
 uniform mat3 obj2normal;
 uniform mat4 world2cam;
 uniform mat4 projection;
 
-void main() {
-	gl_Position = projection * world2cam * obj2world * vec4(aPos, 1.0);
-	fragPos = vec3(obj2world * vec4(aPos, 1.0));
-	inputNormal = obj2normal * aNormal;
-	vertDiffuse = aDiffuse;
-	vertSpecular = aSpecular;
+// only used by heightmap terrain, which has no vertex attributes
+uniform bool heightmapEnabled;
+uniform sampler2D heightmap; // has a 1 sample border
+uniform ivec2 heightmapSamples; // not including the border
+uniform vec2 heightmapSpacing; // distance between samples on x and z
+
+uniform bool morphEnabled;
+uniform vec2 morphRange; // distances where morphing starts and finishes
+uniform vec3 morphCameraPos; // in world space
+
+// texel is relative to the first sample, not the border
+float heightAt(ivec2 texel) {
+	return texelFetch(heightmap, texel + ivec2(1), 0).r;
 }
 
+void main() {
+	vec3 position = aPos;
+	vec3 normal = aNormal;
+	if (heightmapEnabled) {
+		// same layout as TerrainGenerator's verticies
+		ivec2 coord = ivec2(gl_VertexID % heightmapSamples.x, gl_VertexID / heightmapSamples.x);
+		float height = heightAt(coord);
+		position = vec3(coord.x * heightmapSpacing.x, height, coord.y * heightmapSpacing.y);
+
+		// central differences, like NormalMethod::heightGrid
+		float slopeX = (heightAt(coord + ivec2(1, 0)) - heightAt(coord - ivec2(1, 0)))
+		             / (2 * heightmapSpacing.x);
+		float slopeZ = (heightAt(coord + ivec2(0, 1)) - heightAt(coord - ivec2(0, 1)))
+		             / (2 * heightmapSpacing.y);
+		normal = normalize(vec3(-slopeX, 1, -slopeZ));
+	}
+
+	if (morphEnabled) {
+		float dist = distance(vec3(obj2world * vec4(aPos, 1.0)), morphCameraPos);
+		float morph = clamp((dist - morphRange.x) / (morphRange.y - morphRange.x), 0.0, 1.0);
+		position = mix(position, aMorphPos, morph);
+		normal = mix(normal, aMorphNormal, morph);
+	}
+
+	gl_Position = projection * world2cam * obj2world * vec4(position, 1.0);
+	fragPos = vec3(obj2world * vec4(position, 1.0));
+	inputNormal = obj2normal * normal;
+	vertHeight = position.y;
+}
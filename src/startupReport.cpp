@@ -0,0 +1,87 @@
+#include "startupReport.hpp"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <print>
+
+StartupReport::StartupReport() {
+	this->origin = std::chrono::steady_clock::now();
+	this->running = 0;
+	this->recording = true;
+}
+
+StartupReport::Phase StartupReport::begin(const std::string& name, const std::string& item) {
+	Phase phase;
+	std::lock_guard lock{this->mutex};
+	if (not this->recording) return phase;
+	phase.report = this;
+	phase.index = this->entries.size();
+	this->entries.push_back({name, item, this->now(), std::nullopt});
+	this->running++;
+	return phase;
+}
+
+double StartupReport::end(const size_t index) {
+	double end = this->now();
+	std::lock_guard lock{this->mutex};
+	Entry& entry = this->entries[index];
+	entry.end = end;
+	this->running--;
+	return end - entry.start;
+}
+
+bool StartupReport::isComplete() const {
+	std::lock_guard lock{this->mutex};
+	return this->running == 0;
+}
+
+void StartupReport::stop() {
+	std::lock_guard lock{this->mutex};
+	this->recording = false;
+}
+
+// quoted, with anything JSON doesn't allow in a string escaped
+static std::string jsonString(const std::string& string) {
+	std::string out = "\"";
+	for (char ch : string) {
+		switch (ch) {
+		case '"': out += "\\\""; break;
+		case '\\': out += "\\\\"; break;
+		case '\n': out += "\\n"; break;
+		case '\t': out += "\\t"; break;
+		default:
+			if ((unsigned char)ch < 0x20) out += std::format("\\u{:04x}", (int)ch);
+			else out += ch;
+		}
+	}
+	return out + "\"";
+}
+
+void StartupReport::write(const filesystem::path& path) const {
+	std::lock_guard lock{this->mutex};
+	// until the last phase that's ended
+	double total = 0;
+	for (const Entry& entry : this->entries) total = std::max(total, entry.end.value_or(0));
+
+	std::string json = std::format("{{\n\t\"seconds\": {},\n\t\"phases\": [", total);
+	for (size_t i = 0; i < this->entries.size(); i++) {
+		const Entry& entry = this->entries[i];
+		std::string seconds =
+		    entry.end.has_value() ? std::format("{}", *entry.end - entry.start) : "null";
+		json += std::format("{}\n\t\t{{\"name\": {}, \"item\": {}, ", i == 0 ? "" : ",",
+		                    jsonString(entry.name), jsonString(entry.item));
+		json += std::format("\"start\": {}, \"seconds\": {}}}", entry.start, seconds);
+	}
+	json += "\n\t]\n}\n";
+
+	std::ofstream file{path, std::ios::trunc};
+	file << json;
+	if (not file) std::println(stderr, "Couldn't write the startup report to {}.", path.string());
+	else std::println("Wrote the startup report to {}.", path.string());
+}
+
+StartupReport& getStartupReport() {
+	static StartupReport report{};
+	return report;
+}
@@ -0,0 +1,106 @@
+#ifndef STARTUPREPORT_HPP
+#define STARTUPREPORT_HPP
+
+#include "common.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Times each phase of startup, so --startup-report can write them out and regressions show up.
+// Phases can overlap and nest, and any thread can record them, since models load on the thread
+// pool. Times are in seconds since the report was made, which is the start of main.
+class StartupReport {
+  private:
+	struct Entry {
+		std::string name; // what kind of work, the same every run
+		std::string item; // which shader, model, texture, etc, or empty
+		double start;
+		std::optional<double> end; // nullopt until it's ended
+	};
+
+	std::chrono::steady_clock::time_point origin;
+	mutable std::mutex mutex;
+	std::vector<Entry> entries;
+	uint running; // begun but not ended
+	bool recording;
+
+	double now() const {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - this->origin)
+		    .count();
+	}
+
+	// returns how long it took
+	double end(const size_t index);
+
+	StartupReport(const StartupReport&) = delete;
+	StartupReport& operator=(const StartupReport&) = delete;
+
+  public:
+	// One phase being timed. It ends when end() is called or it's destroyed, whichever's first.
+	// Default constructed ones aren't timing anything.
+	class Phase {
+	  private:
+		StartupReport* report; // null once it's ended
+		size_t index;
+
+		Phase(const Phase&) = delete;
+		Phase& operator=(const Phase&) = delete;
+
+		friend class StartupReport;
+
+	  public:
+		Phase() : report(nullptr), index(0) {}
+
+		Phase(Phase&& other) noexcept
+		    : report(std::exchange(other.report, nullptr)), index(other.index) {}
+
+		Phase& operator=(Phase&& other) noexcept {
+			if (this != &other) {
+				this->end();
+				this->report = std::exchange(other.report, nullptr);
+				this->index = other.index;
+			}
+			return *this;
+		}
+
+		// returns how long it took, or 0 if it wasn't timing anything
+		double end() {
+			if (not this->report) return 0;
+			return std::exchange(this->report, nullptr)->end(this->index);
+		}
+
+		~Phase() { this->end(); }
+	};
+
+	StartupReport();
+
+	// starts timing a phase; nothing is timed once recording has stopped
+	Phase begin(const std::string& name, const std::string& item = "");
+
+	// times func as one phase, and returns what it does
+	template <typename Func>
+	auto time(const std::string& name, const std::string& item, Func&& func) {
+		Phase phase = this->begin(name, item);
+		return func();
+	}
+
+	// whether every phase that's begun has ended
+	bool isComplete() const;
+
+	// Stops recording, so work done after startup, like reloading an evicted texture, isn't
+	// counted.
+	void stop();
+
+	// Writes every phase as JSON, in the order they began. Phases still going have null seconds.
+	// Prints an error instead of throwing, since the report isn't worth crashing over.
+	void write(const filesystem::path& path) const;
+};
+
+StartupReport& getStartupReport();
+
+#endif /* STARTUPREPORT_HPP */
@@ -1,3 +1,6 @@
-// build stb image in this file to save compile time on future builds
+// build stb image and dxt in this file to save compile time on future builds
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
@@ -0,0 +1,306 @@
+#include "terrainQuadtree.hpp"
+
+#include "shaderStructs.hpp"
+#include "threadPool.hpp"
+
+#include <glad/gl.h>
+
+#include <glm/common.hpp>
+#include <glm/matrix.hpp>
+
+#include <bit>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <stdexcept>
+
+TerrainQuadtree::TerrainQuadtree(const ulong seed, const float shininess,
+                                 const DSColor& bottomColor, const DSColor& topColor,
+                                 const glm::vec2& sampleSpacing, const float height,
+                                 const uint nodeSamples, const uint levels,
+                                 const NormalMethod normalMethod, const float pixelError,
+                                 const Shaders::Terrain shader)
+    : BaseSceneGraphObject(glm::mat4(1)) {
+	if (nodeSamples < 3 or (nodeSamples - 1) % 2 != 0)
+		throw std::invalid_argument(
+		    std::format("Quadtree nodes need an odd number of samples, got {}.", nodeSamples));
+	if (levels == 0) throw std::invalid_argument("A quadtree needs at least one level.");
+
+	this->material = makeTerrainMaterial(shininess, bottomColor, topColor, height);
+	this->shader = shader;
+	this->nodeSamples = nodeSamples;
+	this->levels = levels;
+	this->pixelError = pixelError;
+	this->nodeSize = sampleSpacing * (float)(nodeSamples - 1);
+	this->ranges = std::vector<float>(levels);
+
+	this->buildIndicies();
+	this->build(seed, sampleSpacing, height, normalMethod);
+}
+
+void TerrainQuadtree::buildIndicies() {
+	const uint half = (this->nodeSamples - 1) / 2;
+	std::vector<uint> indicies;
+	indicies.reserve(4 * half * half * 6);
+
+	auto flatten = [&](const uint x, const uint y) { return y * this->nodeSamples + x; };
+
+	// same triangles as TerrainGenerator, but quadrant by quadrant
+	for (uint quadrant = 0; quadrant < 4; quadrant++) {
+		glm::uvec2 corner = glm::uvec2(quadrant % 2, quadrant / 2) * half;
+		for (uint y = corner.y; y < corner.y + half; y++) {
+			for (uint x = corner.x; x < corner.x + half; x++) {
+				// first half of square
+				indicies.push_back(flatten(x, y + 1));
+				indicies.push_back(flatten(x + 1, y));
+				indicies.push_back(flatten(x, y));
+				// second half of square
+				indicies.push_back(flatten(x, y + 1));
+				indicies.push_back(flatten(x + 1, y + 1));
+				indicies.push_back(flatten(x + 1, y));
+			}
+		}
+	}
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO.get());
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, VECTOR_SIZE_BYTES(indicies), indicies.data(),
+	             GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void TerrainQuadtree::build(const ulong seed, const glm::vec2& sampleSpacing, const float height,
+                            const NormalMethod normalMethod) {
+	const uint samples = this->nodeSamples;
+	const uint cells = samples - 1;
+	const uint top = this->levels - 1;
+	ThreadPool& pool = getThreadPool();
+
+	// [level][node], same layout as this->nodes
+	std::vector<std::vector<TerrainGeometry>> geometry(this->levels);
+
+	for (uint level = 0; level < this->levels; level++) {
+		// the generator's scale is size / samples, so this spaces samples out by 2^level
+		glm::vec2 spacing = sampleSpacing * (float)(1u << level);
+		TerrainGenerator generator{
+		    seed, glm::vec3(spacing * (float)samples, height), glm::uvec2(samples), normalMethod};
+
+		const uint across = this->nodesAcross(level);
+		geometry[level].resize(across * across);
+		pool.parallelFor(across * across, defaultThreadCount(), [&](uint begin, uint end) {
+			for (uint i = begin; i < end; i++) {
+				glm::ivec2 offset = glm::ivec2(i % across, i / across) * (int)cells;
+				geometry[level][i] = generator.generateCached(1, offset);
+			}
+		});
+	}
+
+	// The height of the parent's surface at a child sample, given in doubled parent coordinates.
+	// Children's odd samples are halfway along a parent edge, or in the middle of a parent cell,
+	// which lies on the diagonal the index buffer splits cells along, from (x, y + 1) to
+	// (x + 1, y). Either way it's halfway between that edge's ends.
+	auto parentHeight = [&](const TerrainGeometry& parent, const glm::uvec2 doubled) {
+		glm::uvec2 low = doubled / 2u;
+		glm::uvec2 high = (doubled + 1u) / 2u;
+		return (parent.verticies[high.y * samples + low.x].position.y
+		        + parent.verticies[low.y * samples + high.x].position.y)
+		     / 2;
+	};
+
+	this->nodes = std::vector<std::vector<Node>>(this->levels);
+	this->levelErrors = std::vector<float>(this->levels, 0);
+
+	// errors build on the level below, so go up from the finest
+	for (uint level = 0; level < this->levels; level++) {
+		const uint across = this->nodesAcross(level);
+		this->nodes[level].resize(across * across);
+
+		for (uint i = 0; i < across * across; i++) {
+			Node& node = this->nodes[level][i];
+			const std::vector<TerrainVertex>& verticies = geometry[level][i].verticies;
+
+			node.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+			node.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+			for (const TerrainVertex& vertex : verticies) {
+				node.boundsMin = glm::min(node.boundsMin, vertex.position);
+				node.boundsMax = glm::max(node.boundsMax, vertex.position);
+			}
+
+			node.error = 0;
+			if (level == 0) continue;
+			glm::uvec2 coord{i % across, i / across};
+			for (uint quadrant = 0; quadrant < 4; quadrant++) {
+				glm::uvec2 childCoord = coord * 2u + glm::uvec2(quadrant % 2, quadrant / 2);
+				uint child = childCoord.y * across * 2 + childCoord.x;
+				glm::uvec2 corner = glm::uvec2(quadrant % 2, quadrant / 2) * cells;
+
+				const TerrainGeometry& childGeometry = geometry[level - 1][child];
+				float childError = this->nodes[level - 1][child].error;
+				for (uint y = 0; y < samples; y++) {
+					for (uint x = 0; x < samples; x++) {
+						float actual = childGeometry.verticies[y * samples + x].position.y;
+						float expected =
+						    parentHeight(geometry[level][i], corner + glm::uvec2(x, y));
+						node.error = std::max(node.error, childError + std::abs(actual - expected));
+					}
+				}
+			}
+			this->levelErrors[level] = std::max(this->levelErrors[level], node.error);
+		}
+	}
+
+	// Morph targets come from the parent, so every level has to be generated before uploading.
+	// Odd samples move onto their lower even neighbor, which collapses the grid into the
+	// parent's triangles.
+	for (uint level = 0; level < this->levels; level++) {
+		const uint across = this->nodesAcross(level);
+		std::vector<MorphVertex> verticies(samples * samples);
+
+		for (uint i = 0; i < across * across; i++) {
+			glm::uvec2 coord{i % across, i / across};
+			const TerrainGeometry& own = geometry[level][i];
+			// the root has nothing to morph into
+			const uint parentIndex = (coord.y / 2) * (across / 2) + coord.x / 2;
+			const TerrainGeometry& parent = level == top ? own : geometry[level + 1][parentIndex];
+			glm::uvec2 corner = level == top ? glm::uvec2(0) : (coord % 2u) * (cells / 2);
+
+			for (uint y = 0; y < samples; y++) {
+				for (uint x = 0; x < samples; x++) {
+					const TerrainVertex& vertex = own.verticies[y * samples + x];
+					glm::uvec2 target =
+					    level == top ? glm::uvec2(x, y) : corner + glm::uvec2(x, y) / 2u;
+					const TerrainVertex& morphed = parent.verticies[target.y * samples + target.x];
+
+					verticies[y * samples + x] = MorphVertex{
+					    .position = vertex.position,
+					    .normal = vertex.normal,
+					    .morphPosition = morphed.position,
+					    .morphNormal = morphed.normal,
+					};
+				}
+			}
+
+			Node& node = this->nodes[level][i];
+			glBindVertexArray(node.VAO.get());
+
+			glBindBuffer(GL_ARRAY_BUFFER, node.VBO.get());
+			glBufferData(GL_ARRAY_BUFFER, VECTOR_SIZE_BYTES(verticies), verticies.data(),
+			             GL_STATIC_DRAW);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO.get());
+
+			STRUCT_MEMBER_ATTRIB(0, MorphVertex, position);
+			STRUCT_MEMBER_ATTRIB_PACKED_NORMAL(1, MorphVertex, normal);
+			STRUCT_MEMBER_ATTRIB(2, MorphVertex, morphPosition);
+			STRUCT_MEMBER_ATTRIB_PACKED_NORMAL(3, MorphVertex, morphNormal);
+
+			glBindVertexArray(0);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		}
+	}
+}
+
+void TerrainQuadtree::updateRanges(const Camera& camera) {
+	// how many pixels tall something 1 unit tall and 1 unit away is
+	float pixelsPerUnit = camera.projectionMat()[1][1] * camera.getWindowSize().y / 2;
+	const uint top = this->levels - 1;
+
+	for (uint level = 0; level < top; level++) {
+		// Level + 1 takes over once it's accurate enough. Ranges at least double each level,
+		// and start at least a node wide, so neighbors are never more than a level apart.
+		float accurateAt = this->levelErrors[level + 1] * pixelsPerUnit / this->pixelError;
+		float minimum = level == 0 ? 2 * glm::length(this->nodeSize) : 2 * this->ranges[level - 1];
+		this->ranges[level] = std::max(accurateAt, minimum);
+	}
+	this->ranges[top] = std::numeric_limits<float>::max();
+}
+
+// whether any of the box is within range of point
+static bool inRange(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec3& point,
+                    const float range) {
+	glm::vec3 closest = glm::clamp(point, boundsMin, boundsMax);
+	glm::vec3 offset = point - closest;
+	return glm::dot(offset, offset) <= range * range;
+}
+
+bool TerrainQuadtree::selectNode(const uint level, const glm::uvec2 coord,
+                                 const glm::vec3& cameraPos) {
+	const uint index = coord.y * this->nodesAcross(level) + coord.x;
+	const Node& node = this->nodes[level][index];
+	if (not inRange(node.boundsMin, node.boundsMax, cameraPos, this->ranges[level])) return false;
+
+	if (level == 0
+	    or not inRange(node.boundsMin, node.boundsMax, cameraPos, this->ranges[level - 1])) {
+		this->selected.push_back({level, index, 0b1111});
+		return true;
+	}
+
+	// children cover the parts that are close enough, and this node fills in the rest
+	uint quadrants = 0;
+	for (uint quadrant = 0; quadrant < 4; quadrant++) {
+		glm::uvec2 child = coord * 2u + glm::uvec2(quadrant % 2, quadrant / 2);
+		if (not this->selectNode(level - 1, child, cameraPos)) quadrants |= 1u << quadrant;
+	}
+	if (quadrants != 0) this->selected.push_back({level, index, quadrants});
+	return true;
+}
+
+ulong TerrainQuadtree::select(const Camera& camera, const glm::vec3& cameraPos) {
+	this->updateRanges(camera);
+	this->selected.clear();
+	this->selectNode(this->levels - 1, {0, 0}, cameraPos);
+
+	const ulong quadrantTriangles = (ulong)(this->nodeSamples - 1) * (this->nodeSamples - 1) / 2;
+	ulong triangles = 0;
+	for (const Selection& selection : this->selected) {
+		triangles += std::popcount(selection.quadrants) * quadrantTriangles;
+	}
+	return triangles;
+}
+
+void TerrainQuadtree::drawNode(const Selection& selection) {
+	const uint half = (this->nodeSamples - 1) / 2;
+	const uint quadrantIndicies = half * half * 6;
+
+	glBindVertexArray(this->nodes[selection.level][selection.node].VAO.get());
+	if (selection.quadrants == 0b1111) {
+		glDrawElements(GL_TRIANGLES, 4 * quadrantIndicies, GL_UNSIGNED_INT, 0);
+	} else {
+		for (uint quadrant = 0; quadrant < 4; quadrant++) {
+			if (not(selection.quadrants & (1u << quadrant))) continue;
+			glDrawElements(GL_TRIANGLES, quadrantIndicies, GL_UNSIGNED_INT,
+			               (void*)(quadrant * quadrantIndicies * sizeof(uint)));
+		}
+	}
+	glBindVertexArray(0);
+}
+
+void TerrainQuadtree::render(const Camera& camera, const SceneCascade& cascade) {
+	SceneCascade combinedCascade = cascade + this->getNodeCascade();
+	// selection happens in this node's space; morphing happens in world space, so this assumes
+	// the transform doesn't scale
+	glm::vec3 cameraPos =
+	    glm::inverse(combinedCascade.transform) * glm::vec4(camera.getPosition(), 1);
+	this->select(camera, cameraPos);
+
+	this->shader->use();
+	this->shader->setObj2world(combinedCascade.transform);
+	this->shader->setObj2normal(glm::mat3(glm::transpose(glm::inverse(combinedCascade.transform))));
+	this->shader->setWorld2cam(camera.toCamSpace());
+	this->shader->setProjection(camera.projectionMat());
+	this->shader->setViewPos(camera.getPosition());
+	this->shader->setMaterial(this->material);
+	this->shader->setMorphCameraPos(camera.getPosition());
+
+	const uint top = this->levels - 1;
+	for (const Selection& selection : this->selected) {
+		float rangeStart = selection.level == 0 ? 0 : this->ranges[selection.level - 1];
+		float rangeEnd = this->ranges[selection.level];
+		this->shader->setMorphEnabled(selection.level != top);
+		this->shader->setMorphRange({glm::mix(rangeStart, rangeEnd, morphStart), rangeEnd});
+		this->drawNode(selection);
+	}
+
+	// the shader is shared with terrain that doesn't have morph targets
+	this->shader->setMorphEnabled(false);
+	this->shader->stopUsing();
+}
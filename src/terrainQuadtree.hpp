@@ -0,0 +1,117 @@
+#ifndef TERRAINQUADTREE_HPP
+#define TERRAINQUADTREE_HPP
+
+#include "camera.hpp"
+#include "common.hpp"
+#include "genTerrain.hpp"
+#include "glHandle.hpp"
+#include "sceneObject.hpp"
+#include "terrain.hpp"
+
+#include <glm/ext/vector_float2.hpp>
+#include <glm/ext/vector_float3.hpp>
+
+#include <vector>
+
+#pragma pack(push, 1)
+
+// a TerrainVertex, and where it ends up once morphed into the next coarser level
+struct MorphVertex {
+	glm::vec3 position;
+	uint normal; // packed with glm::packSnorm3x10_1x2
+	glm::vec3 morphPosition;
+	uint morphNormal;
+};
+
+#pragma pack(pop)
+
+// CDLOD-style terrain. Every node is the same grid of samples, but each level's samples are twice
+// as far apart as the one below it, so a single root covers the whole terrain. Each frame, nodes
+// are picked by how many pixels of error they'd cause from the camera, and vertices near the edge
+// of a level's range morph into the next level so switching doesn't pop.
+// Owns every node's VAO and buffers, so it's move only.
+class TerrainQuadtree : public BaseSceneGraphObject {
+  private:
+	struct Node {
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		float error; // max height difference from the finest level
+		GlVertexArray VAO;
+		GlBuffer VBO;
+	};
+
+	// a node to draw, and which of its quadrants to draw
+	struct Selection {
+		uint level;
+		uint node;
+		uint quadrants; // bit (y * 2 + x) is set for each quadrant that's drawn
+	};
+
+	// how far into a level's range morphing starts, from 0 to 1
+	static constexpr float morphStart = 0.7;
+
+	Shaders::TerrMaterial material;
+	Shaders::Terrain shader;
+	uint nodeSamples; // along each edge
+	uint levels;
+	float pixelError; // how many pixels off the terrain is allowed to be
+	glm::vec2 nodeSize; // in world units, for level 0
+
+	// [level][y * nodesAcross + x], level 0 is the finest
+	std::vector<std::vector<Node>> nodes;
+	std::vector<float> levelErrors; // max error of any node in each level
+	GlBuffer EBO; // shared by every node, sorted by quadrant
+
+	std::vector<float> ranges; // how far from the camera each level is used
+	std::vector<Selection> selected;
+
+	uint nodesAcross(const uint level) const { return 1u << (this->levels - 1 - level); }
+
+	// generates every level and uploads it
+	void build(const ulong seed, const glm::vec2& sampleSpacing, const float height,
+	           const NormalMethod normalMethod);
+
+	// index buffer for one node's grid, with each quadrant contiguous
+	void buildIndicies();
+
+	// ranges depend on the projection, so they're recalculated every frame
+	void updateRanges(const Camera& camera);
+
+	// returns false if the node is too far for its level, leaving it to the parent
+	bool selectNode(const uint level, const glm::uvec2 coord, const glm::vec3& cameraPos);
+
+	void drawNode(const Selection& selection);
+
+	TerrainQuadtree(const TerrainQuadtree&) = delete;
+	TerrainQuadtree& operator=(const TerrainQuadtree&) = delete;
+
+  public:
+	// nodeSamples - 1 must be even, so each node can be split into quadrants
+	// the terrain is sampleSpacing * (nodeSamples - 1) * 2^(levels - 1) across
+	TerrainQuadtree(const ulong seed, const float shininess, const DSColor& bottomColor,
+	                const DSColor& topColor, const glm::vec2& sampleSpacing, const float height,
+	                const uint nodeSamples, const uint levels, const NormalMethod normalMethod,
+	                const float pixelError, const Shaders::Terrain shader);
+
+	// Picks nodes to draw for a camera at cameraPos, in this node's space. Returns how many
+	// triangles they contain.
+	ulong select(const Camera& camera, const glm::vec3& cameraPos);
+
+	virtual void render(const Camera& camera, const SceneCascade& cascade);
+
+	virtual void print(const SceneCascade& cascade) {
+		std::println("{}TerrainQuadtree: {} levels, {} nodes drawn",
+		             std::string(SCENE_GRAPH_INDENT * cascade.recurseDepth, ' '), this->levels,
+		             this->selected.size());
+	}
+
+	// width of the whole terrain along x and z
+	glm::vec2 getSize() const { return this->nodeSize * (float)this->nodesAcross(0); }
+
+	TerrainQuadtree(TerrainQuadtree&&) = default;
+	TerrainQuadtree& operator=(TerrainQuadtree&&) = default;
+
+	virtual ~TerrainQuadtree() = default;
+};
+
+#endif /* TERRAINQUADTREE_HPP */
@@ -0,0 +1,139 @@
+#include "terrainStreamer.hpp"
+
+#include "threadPool.hpp"
+
+#include <glm/matrix.hpp>
+
+#include <chrono>
+#include <format>
+#include <span>
+#include <stdexcept>
+
+TerrainStreamer::TerrainStreamer(const ulong seed, const float shininess,
+                                 const DSColor& bottomColor, const DSColor& topColor,
+                                 const glm::vec2& sampleSpacing, const float height,
+                                 const uint chunkSamples, const NormalMethod normalMethod,
+                                 const uint viewRadius, const size_t budgetBytes,
+                                 const Shaders::Terrain shader)
+    : BaseSceneGraphObject(glm::mat4(1)) {
+	// every chunk uses the same generator, just with a different offset
+	glm::vec3 size{sampleSpacing * (float)chunkSamples, height};
+	this->generator = std::make_shared<const TerrainGenerator>(
+	    seed, size, glm::uvec2(chunkSamples), normalMethod);
+	std::optional<SplitGridIndicies> indicies =
+	    TerrainGenerator::splitGridIndicies(glm::uvec2(chunkSamples), defaultThreadCount());
+	if (not indicies.has_value())
+		throw std::invalid_argument(
+		    std::format("Chunks can't be {} samples wide, the limit is 32768.", chunkSamples));
+	this->indicies = std::move(*indicies);
+	std::shared_ptr<GlBuffer> EBO = std::make_shared<GlBuffer>();
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO->get());
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, VECTOR_SIZE_BYTES(this->indicies.indicies),
+	             this->indicies.indicies.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	this->EBO = EBO;
+	this->material = makeTerrainMaterial(shininess, bottomColor, topColor, height);
+	this->shader = shader;
+	this->viewRadius = viewRadius;
+	this->budgetBytes = budgetBytes;
+	this->uploadsPerFrame = 2;
+	this->residentBytes = VECTOR_SIZE_BYTES(this->indicies.indicies);
+	this->frame = 0;
+}
+
+glm::vec2 TerrainStreamer::chunkSize() const {
+	// neighbors share an edge, so a chunk is one sample shorter than it has samples
+	glm::vec3 scale = this->generator->getScale();
+	glm::uvec2 samples = this->generator->getSamples();
+	return {scale.x * (samples.x - 1), scale.y * (samples.y - 1)};
+}
+
+TerrainStreamer::ChunkCoord TerrainStreamer::chunkAt(const glm::vec3& position) const {
+	glm::vec2 size = this->chunkSize();
+	return {(int)std::floor(position.x / size.x), (int)std::floor(position.z / size.y)};
+}
+
+void TerrainStreamer::requestChunks(const ChunkCoord center) {
+	const int radius = this->viewRadius;
+	const glm::ivec2 chunkSamples = glm::ivec2(this->generator->getSamples()) - 1;
+
+	for (int dz = -radius; dz <= radius; dz++) {
+		for (int dx = -radius; dx <= radius; dx++) {
+			if (dx * dx + dz * dz > radius * radius) continue; // keep it roughly circular
+
+			ChunkCoord coord{center.first + dx, center.second + dz};
+			auto [iter, inserted] = this->chunks.try_emplace(coord);
+			Chunk& chunk = iter->second;
+			chunk.lastSeenFrame = this->frame;
+
+			if (inserted) {
+				glm::ivec2 offset = glm::ivec2(coord.first, coord.second) * chunkSamples;
+				// the task holds its own reference, so it's fine if this node is gone by then
+				chunk.pending = getThreadPool().submit([generator = this->generator, offset] {
+					return generator->generateCached(1, offset);
+				});
+			}
+		}
+	}
+}
+
+void TerrainStreamer::uploadFinished() {
+	uint uploads = 0;
+	for (auto iter = this->chunks.begin(); iter != this->chunks.end();) {
+		Chunk& chunk = iter->second;
+		bool isReady = chunk.pending.valid()
+		           and chunk.pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+
+		if (isReady and chunk.lastSeenFrame != this->frame) {
+			// walked away before it finished
+			iter = this->chunks.erase(iter);
+			continue;
+		}
+
+		if (isReady and uploads < this->uploadsPerFrame) {
+			TerrainGeometry geometry = chunk.pending.get();
+			// every chunk draws from the same index buffer, so only the verticies are uploaded
+			chunk.mesh = std::make_shared<Mesh<TerrainVertex, Shaders::Terrain, ushort>>(
+			    std::span<const TerrainVertex>(geometry.verticies), this->EBO,
+			    this->indicies.indicies.size(), this->material, this->shader);
+			chunk.mesh->setRanges(this->indicies.ranges);
+			this->residentBytes += chunk.mesh->gpuBytes();
+			uploads++;
+		}
+		iter++;
+	}
+}
+
+void TerrainStreamer::evict() {
+	while (this->residentBytes > this->budgetBytes) {
+		auto oldest = this->chunks.end();
+		for (auto iter = this->chunks.begin(); iter != this->chunks.end(); iter++) {
+			const Chunk& chunk = iter->second;
+			if (not chunk.mesh or chunk.lastSeenFrame == this->frame) continue;
+			if (oldest == this->chunks.end() or chunk.lastSeenFrame < oldest->second.lastSeenFrame)
+				oldest = iter;
+		}
+		if (oldest == this->chunks.end()) return; // everything left is in view
+
+		this->residentBytes -= oldest->second.mesh->gpuBytes();
+		this->chunks.erase(oldest);
+	}
+}
+
+void TerrainStreamer::render(const Camera& camera, const SceneCascade& cascade) {
+	this->frame++;
+
+	// chunks are drawn as if they were children of this node
+	SceneCascade combinedCascade = cascade + this->getNodeCascade();
+	glm::vec3 cameraPos =
+	    glm::inverse(combinedCascade.transform) * glm::vec4(camera.getPosition(), 1);
+
+	this->requestChunks(this->chunkAt(cameraPos));
+	this->uploadFinished();
+	this->evict();
+
+	for (auto& [coord, chunk] : this->chunks) {
+		if (chunk.mesh and chunk.lastSeenFrame == this->frame)
+			chunk.mesh->render(camera, combinedCascade);
+	}
+}
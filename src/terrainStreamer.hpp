@@ -0,0 +1,86 @@
+#ifndef TERRAINSTREAMER_HPP
+#define TERRAINSTREAMER_HPP
+
+#include "common.hpp"
+#include "genTerrain.hpp"
+#include "glHandle.hpp"
+#include "mesh.hpp"
+#include "sceneObject.hpp"
+#include "terrain.hpp"
+
+#include <future>
+#include <map>
+#include <memory>
+#include <utility>
+
+// Tiles an unbounded world into square chunks of terrain. Chunks near the camera are generated on
+// the thread pool and uploaded once they're done. When the chunks' GPU memory goes over the budget,
+// the least recently seen ones are evicted.
+class TerrainStreamer : public BaseSceneGraphObject {
+  private:
+	// in chunks, not world units
+	typedef std::pair<int, int> ChunkCoord;
+
+	struct Chunk {
+		std::future<TerrainGeometry> pending; // valid until the geometry is uploaded
+		// null until uploaded
+		std::shared_ptr<Mesh<TerrainVertex, Shaders::Terrain, ushort>> mesh;
+		ulong lastSeenFrame;
+	};
+
+	// shared with any generation tasks that are still running
+	std::shared_ptr<const TerrainGenerator> generator;
+	// Every chunk is the same grid, so they all draw from one index buffer. It's counted in
+	// residentBytes once, since evicting chunks doesn't free it.
+	std::shared_ptr<const GlBuffer> EBO;
+	SplitGridIndicies indicies; // only the ranges and size are used after uploading
+	Shaders::TerrMaterial material;
+	Shaders::Terrain shader;
+	uint viewRadius; // in chunks
+	size_t budgetBytes;
+	uint uploadsPerFrame; // limits how much time uploads can take each frame
+
+	std::map<ChunkCoord, Chunk> chunks;
+	size_t residentBytes;
+	ulong frame;
+
+	// world size of a chunk along x and z
+	glm::vec2 chunkSize() const;
+
+	// which chunk a position in this node's space is in
+	ChunkCoord chunkAt(const glm::vec3& position) const;
+
+	// marks chunks near center as seen, queueing any that don't exist yet
+	void requestChunks(const ChunkCoord center);
+
+	// uploads generated chunks, dropping any that are out of view by now
+	void uploadFinished();
+
+	// evicts least recently seen chunks until under budget
+	// never evicts chunks seen this frame
+	void evict();
+
+  public:
+	// chunkSamples is the number of samples along each edge, including the one shared with the
+	// neighboring chunk
+	TerrainStreamer(const ulong seed, const float shininess, const DSColor& bottomColor,
+	                const DSColor& topColor, const glm::vec2& sampleSpacing, const float height,
+	                const uint chunkSamples, const NormalMethod normalMethod,
+	                const uint viewRadius, const size_t budgetBytes,
+	                const Shaders::Terrain shader);
+
+	// streams chunks in and out, then draws the visible ones
+	virtual void render(const Camera& camera, const SceneCascade& cascade);
+
+	virtual void print(const SceneCascade& cascade) {
+		std::println("{}TerrainStreamer: {} chunks, {:.1f} MiB",
+		             std::string(SCENE_GRAPH_INDENT * cascade.recurseDepth, ' '),
+		             this->chunks.size(), this->residentBytes / (1024. * 1024.));
+	}
+
+	size_t getResidentBytes() const { return this->residentBytes; }
+
+	virtual ~TerrainStreamer() = default;
+};
+
+#endif /* TERRAINSTREAMER_HPP */
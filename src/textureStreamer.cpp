@@ -0,0 +1,147 @@
+#include "textureStreamer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+
+TextureStreamer::TextureStreamer(const size_t frameBudget) {
+	this->frameBudget = frameBudget;
+	this->nextSlot = 0;
+}
+
+void TextureStreamer::freeRing() {
+	for (Slot& slot : this->ring) {
+		if (slot.fence) glDeleteSync(slot.fence);
+	}
+	this->ring.clear();
+	this->nextSlot = 0;
+}
+
+void TextureStreamer::setBudget(const size_t frameBudget) {
+	if (frameBudget == 0) throw std::invalid_argument("The texture upload budget can't be 0.");
+	this->frameBudget = frameBudget;
+	// remade at the new size when it's next needed
+	this->freeRing();
+}
+
+std::shared_ptr<GpuTexture> TextureStreamer::upload(const std::shared_future<MipChain>& chain) {
+	const MipChain& levels = chain.get();
+	uint texture = allocateMipChain(levels);
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	uint level = levels.levels.size();
+	while (level > 0
+	       and std::max(levels.sizes[level - 1].x, levels.sizes[level - 1].y) <= immediateSize) {
+		level--;
+		uploadMipRows(levels, level, 0, mipLevelRows(levels, level), levels.levels[level].data());
+	}
+	// only sample what's been uploaded
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	auto handle = std::make_shared<GpuTexture>(texture, mipChainBytes(levels));
+	if (level > 0) this->jobs.push_back({handle, chain, level - 1, 0});
+	return handle;
+}
+
+void TextureStreamer::update() {
+	if (this->jobs.empty()) return;
+
+	if (this->ring.empty()) {
+		this->ring.reserve(slotCount);
+		for (uint i = 0; i < slotCount; i++) {
+			Slot& slot = this->ring.emplace_back(GlBuffer{}, nullptr);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer.get());
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, this->frameBudget, nullptr, GL_STREAM_DRAW);
+		}
+	}
+
+	// the GPU is behind, so come back next frame instead of waiting
+	Slot& slot = this->ring[this->nextSlot];
+	if (slot.fence) {
+		if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED) return;
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+	}
+
+	// a run of rows copied into the slot, uploaded once it's unmapped
+	struct Piece {
+		std::shared_ptr<const GpuTexture> texture;
+		std::shared_future<MipChain> chain;
+		uint level;
+		uint firstRow;
+		uint rowCount;
+		size_t offset;
+		bool finishesLevel;
+	};
+	std::vector<Piece> pieces;
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer.get());
+	// invalidating lets the driver hand out fresh memory instead of syncing
+	std::byte* mapped = static_cast<std::byte*>(
+	    glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, this->frameBudget,
+	                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	size_t used = 0;
+	while (not this->jobs.empty()) {
+		Job& job = this->jobs.front();
+		std::shared_ptr<const GpuTexture> texture = job.texture.lock();
+		if (not texture) {
+			this->jobs.pop_front();
+			continue;
+		}
+
+		const MipChain& chain = job.chain.get();
+		const uint rows = mipLevelRows(chain, job.level);
+		const size_t rowBytes = chain.levels[job.level].size() / rows;
+		const uint fits = std::min<size_t>(rows - job.row, (this->frameBudget - used) / rowBytes);
+		if (fits == 0) {
+			if (used == 0)
+				throw std::runtime_error(std::format(
+				    "A {} byte texture row doesn't fit in the {} byte upload budget.", rowBytes,
+				    this->frameBudget));
+			break;
+		}
+
+		std::memcpy(mapped + used, chain.levels[job.level].data() + job.row * rowBytes,
+		            fits * rowBytes);
+		pieces.push_back({texture, job.chain, job.level, job.row, fits, used,
+		                  job.row + fits == rows});
+		used += fits * rowBytes;
+		job.row += fits;
+		if (job.row < rows) continue;
+		if (job.level == 0) {
+			this->jobs.pop_front();
+		} else {
+			job.level--;
+			job.row = 0;
+		}
+	}
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (const Piece& piece : pieces) {
+		glBindTexture(GL_TEXTURE_2D, piece.texture->getId());
+		uploadMipRows(piece.chain.get(), piece.level, piece.firstRow, piece.rowCount,
+		              (const void*)piece.offset);
+		if (piece.finishesLevel) glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, piece.level);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	this->nextSlot = (this->nextSlot + 1) % this->ring.size();
+}
+
+void TextureStreamer::clear() {
+	this->jobs.clear();
+	this->freeRing();
+}
+
+TextureStreamer& getTextureStreamer() {
+	static TextureStreamer streamer{(size_t)8 * 1024 * 1024};
+	return streamer;
+}
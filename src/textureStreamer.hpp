@@ -0,0 +1,76 @@
+#ifndef TEXTURESTREAMER_HPP
+#define TEXTURESTREAMER_HPP
+
+#include "common.hpp"
+#include "glHandle.hpp"
+#include "mipChain.hpp"
+#include "resourceManager.hpp"
+
+#include <glad/gl.h>
+
+#include <deque>
+#include <future>
+#include <memory>
+#include <vector>
+
+// Uploads textures over several frames through a ring of pixel buffer objects, so no frame stalls
+// on one big glTexImage2D. A texture's smallest levels go in as soon as it's made, so it shows up
+// blurry right away. The rest are filled in from small to big, a budget of bytes per frame at a
+// time, and each is only sampled once it's complete. A buffer in the ring is only written once the
+// GPU has finished reading it, so the main thread never waits on the GPU either.
+class TextureStreamer {
+  private:
+	// a pixel buffer, and a fence for the uploads reading from it
+	struct Slot {
+		GlBuffer buffer;
+		GLsync fence;
+	};
+
+	// a texture with levels still to upload
+	struct Job {
+		std::weak_ptr<const GpuTexture> texture; // dropped if it's freed before it's done
+		std::shared_future<MipChain> chain; // keeps the levels alive
+		uint level; // the next one to upload, counting down to 0
+		uint row; // in mipLevelRows
+	};
+
+	size_t frameBudget; // bytes, and the size of each slot
+	std::vector<Slot> ring; // made on the first upload
+	uint nextSlot;
+	std::deque<Job> jobs;
+
+	void freeRing();
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+  public:
+	// levels at most this big across are uploaded right away
+	static constexpr uint immediateSize = 64;
+	static constexpr uint slotCount = 3;
+
+	TextureStreamer(const size_t frameBudget);
+
+	void setBudget(const size_t frameBudget);
+	size_t getBudget() const { return this->frameBudget; }
+
+	// Makes the texture and uploads its smallest levels, then queues the rest. chain has to be
+	// ready. Main thread only.
+	std::shared_ptr<GpuTexture> upload(const std::shared_future<MipChain>& chain);
+
+	// Uploads queued levels until this frame's budget runs out, or skips the frame if the next
+	// buffer is still being read. Call once a frame, on the main thread.
+	void update();
+
+	// whether every level of every texture has been uploaded
+	bool isIdle() const { return this->jobs.empty(); }
+
+	// Drops every upload and frees the ring. Has to happen while the GL context is still around.
+	void clear();
+
+	~TextureStreamer() { this->freeRing(); }
+};
+
+TextureStreamer& getTextureStreamer();
+
+#endif /* TEXTURESTREAMER_HPP */
@@ -0,0 +1,93 @@
+#include "threadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <latch>
+#include <memory>
+
+ThreadPool::ThreadPool(const uint threadCount) {
+	this->workers.reserve(threadCount);
+	for (uint i = 0; i < threadCount; i++) {
+		this->workers.emplace_back([this](std::stop_token stopToken) { this->workerLoop(stopToken); });
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	for (std::jthread& worker : this->workers) {
+		worker.request_stop();
+	}
+	this->condition.notify_all();
+	// jthreads join themselves
+}
+
+void ThreadPool::workerLoop(std::stop_token stopToken) {
+	while (true) {
+		std::move_only_function<void()> task;
+		{
+			std::unique_lock lock{this->mutex};
+			// returns false if stop was requested while the queue is empty
+			if (not this->condition.wait(lock, stopToken, [this] { return not this->tasks.empty(); }))
+				return;
+			task = std::move(this->tasks.front());
+			this->tasks.pop_front();
+		}
+		task();
+	}
+}
+
+void ThreadPool::parallelFor(const uint count, const uint maxThreads,
+                             const std::function<void(uint, uint)>& body) {
+	uint blocks = std::min({count, std::max(maxThreads, 1u), this->getThreadCount() + 1});
+	if (blocks <= 1) {
+		if (count > 0) body(0, count);
+		return;
+	}
+
+	// block b covers [blockStart(b), blockStart(b + 1))
+	auto blockStart = [count, blocks](const uint block) {
+		return static_cast<uint>(static_cast<unsigned long long>(count) * block / blocks);
+	};
+
+	// Shared with the helper tasks, which can start after this returns if the pool was busy. By
+	// then every block has been claimed, so they return without touching body.
+	struct Blocks {
+		std::atomic<uint> next{0};
+		std::latch remaining;
+		std::mutex errorMutex;
+		std::exception_ptr error = nullptr;
+
+		Blocks(const uint count) : remaining(count) {}
+	};
+	std::shared_ptr<Blocks> shared = std::make_shared<Blocks>(blocks);
+
+	// claims and runs blocks until they've all been claimed
+	auto runBlocks = [shared, &body, blockStart, blocks]() {
+		for (uint block = shared->next++; block < blocks; block = shared->next++) {
+			try {
+				body(blockStart(block), blockStart(block + 1));
+			} catch (...) {
+				std::lock_guard lock{shared->errorMutex};
+				if (not shared->error) shared->error = std::current_exception();
+			}
+			shared->remaining.count_down();
+		}
+	};
+
+	for (uint helper = 1; helper < blocks; helper++) this->submit(runBlocks);
+	runBlocks();
+
+	// only blocks another thread is already running are left, so this can't deadlock
+	shared->remaining.wait();
+
+	if (shared->error) std::rethrow_exception(shared->error);
+}
+
+uint defaultThreadCount() { return std::max(std::thread::hardware_concurrency(), 1u); }
+
+ThreadPool& getThreadPool() {
+	// the calling thread also does work in parallelFor, so leave a core for it
+	// always keep at least one worker so submitted tasks can run
+	static ThreadPool pool{std::max(defaultThreadCount() - 1, 1u)};
+	return pool;
+}
@@ -0,0 +1,63 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include "common.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// a fixed set of worker threads that run queued tasks in FIFO order
+class ThreadPool {
+  private:
+	std::vector<std::jthread> workers;
+	std::deque<std::move_only_function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable_any condition;
+
+	void workerLoop(std::stop_token stopToken);
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+  public:
+	ThreadPool(const uint threadCount);
+
+	~ThreadPool();
+
+	uint getThreadCount() const { return this->workers.size(); }
+
+	// queue a task; the returned future holds its result (or exception)
+	template <typename Func> std::future<std::invoke_result_t<Func>> submit(Func&& task) {
+		std::packaged_task<std::invoke_result_t<Func>()> packaged{std::forward<Func>(task)};
+		auto future = packaged.get_future();
+		{
+			std::lock_guard lock{this->mutex};
+			this->tasks.emplace_back(std::move(packaged));
+		}
+		this->condition.notify_one();
+		return future;
+	}
+
+	// Splits [0, count) into at most maxThreads contiguous blocks and calls body(begin, end) on
+	// each, blocking until all of them finish. Workers and the calling thread claim blocks as they
+	// get to them, so if the pool is busy the caller runs them all, and nesting this inside a pool
+	// task can't deadlock. The caller never runs other queued tasks, so a long one like a model
+	// import can't hold it up.
+	void parallelFor(const uint count, const uint maxThreads,
+	                 const std::function<void(uint, uint)>& body);
+};
+
+// the number of threads worth using on this machine; never 0
+uint defaultThreadCount();
+
+// Shared pool with defaultThreadCount() - 1 workers, but at least one. The last core is left for
+// the calling thread, which runs a block of each parallelFor itself. Created on first use.
+ThreadPool& getThreadPool();
+
+#endif /* THREADPOOL_HPP */
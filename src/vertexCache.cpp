@@ -0,0 +1,294 @@
+#include "vertexCache.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+// A FIFO cache of vertices, like most GPUs have. The miss count doubles as the clock, so a vertex
+// is pushed out after size more misses.
+class FifoCache {
+  private:
+	std::vector<ulong> insertedAt;
+	ulong misses;
+	uint size;
+
+  public:
+	FifoCache(const uint vertexCount, const uint size) : insertedAt(vertexCount, 0) {
+		this->misses = 0;
+		this->size = size;
+	}
+
+	// whether index had to be loaded
+	bool access(const uint index) {
+		if (this->insertedAt[index] != 0 and this->misses - this->insertedAt[index] < this->size)
+			return false;
+		this->misses++;
+		this->insertedAt[index] = this->misses;
+		return true;
+	}
+
+	// how many of a triangle's vertices had to be loaded
+	uint accessTriangle(const uint* triangle) {
+		return this->access(triangle[0]) + this->access(triangle[1]) + this->access(triangle[2]);
+	}
+
+	// pushes everything out
+	void flush() { this->misses += this->size; }
+
+	ulong getMisses() const { return this->misses; }
+};
+
+VertexCacheStats simulateVertexCache(const std::span<const uint> indicies, const uint vertexCount,
+                                     const uint cacheSize) {
+	FifoCache cache{vertexCount, cacheSize};
+	for (uint index : indicies) cache.access(index);
+
+	return {
+	    .acmr = (double)cache.getMisses() / (indicies.size() / 3),
+	    .atvr = (double)cache.getMisses() / vertexCount,
+	};
+}
+
+// tuning from Forsyth's article
+static constexpr uint forsythCacheSize = 32;
+static constexpr float cacheDecayPower = 1.5;
+static constexpr float lastTriangleScore = 0.75;
+static constexpr float valenceBoostScale = 2;
+static constexpr float valenceBoostPower = 0.5;
+
+// the scores only depend on small integers, so they're worked out once up front
+static constexpr uint valenceTableSize = 32;
+
+struct ScoreTables {
+	std::array<float, forsythCacheSize> cache;
+	std::array<float, valenceTableSize> valence;
+
+	ScoreTables() {
+		for (uint i = 0; i < forsythCacheSize; i++) {
+			// the last triangle's vertices get a fixed score, so the next one doesn't just pick
+			// whichever one of them is first
+			if (i < 3) this->cache[i] = lastTriangleScore;
+			else
+				this->cache[i] =
+				    std::pow(1 - (float)(i - 3) / (forsythCacheSize - 3), cacheDecayPower);
+		}
+		for (uint i = 0; i < valenceTableSize; i++) this->valence[i] = valenceBoost(i);
+	}
+
+	// finishing off vertices with few triangles left means they don't need to be loaded again
+	static float valenceBoost(const uint remainingTriangles) {
+		return valenceBoostScale * std::pow((float)remainingTriangles, -valenceBoostPower);
+	}
+};
+
+// cachePosition is -1 if the vertex isn't cached
+static float vertexScore(const int cachePosition, const uint remainingTriangles) {
+	static const ScoreTables tables;
+
+	// nothing left to draw with it
+	if (remainingTriangles == 0) return -1;
+
+	float score = cachePosition >= 0 ? tables.cache[cachePosition] : 0;
+	score += remainingTriangles < valenceTableSize ? tables.valence[remainingTriangles]
+	                                               : ScoreTables::valenceBoost(remainingTriangles);
+	return score;
+}
+
+std::vector<uint> optimizeVertexCache(const std::span<const uint> indicies,
+                                      const uint vertexCount) {
+	const uint triangleCount = indicies.size() / 3;
+
+	// triangles that use each vertex, packed into one array
+	// remaining[v] of them starting at adjacencyStart[v] haven't been drawn yet
+	std::vector<uint> remaining(vertexCount, 0);
+	for (uint index : indicies) remaining[index]++;
+	std::vector<uint> adjacencyStart(vertexCount + 1, 0);
+	for (uint v = 0; v < vertexCount; v++) {
+		adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+	}
+	std::vector<uint> adjacency(indicies.size());
+	std::vector<uint> filled(adjacencyStart.begin(), adjacencyStart.end() - 1);
+	for (uint t = 0; t < triangleCount; t++) {
+		for (uint k = 0; k < 3; k++) adjacency[filled[indicies[t * 3 + k]]++] = t;
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> scores(vertexCount);
+	for (uint v = 0; v < vertexCount; v++) scores[v] = vertexScore(-1, remaining[v]);
+
+	auto triangleScore = [&](const uint t) {
+		return scores[indicies[t * 3]] + scores[indicies[t * 3 + 1]] + scores[indicies[t * 3 + 2]];
+	};
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint> output;
+	output.reserve(indicies.size());
+
+	// most recently used first; briefly holds 3 more than the cache while it's updated
+	std::vector<uint> cache;
+	std::vector<uint> nextCache;
+	cache.reserve(forsythCacheSize + 3);
+	nextCache.reserve(forsythCacheSize + 3);
+
+	uint nextUnemitted = 0;
+	int best = -1;
+	while (output.size() < triangleCount * 3) {
+		if (best < 0) {
+			// nothing cached is worth drawing, so start somewhere new
+			while (emitted[nextUnemitted]) nextUnemitted++;
+			best = nextUnemitted;
+		}
+
+		emitted[best] = true;
+		nextCache.clear();
+		for (uint k = 0; k < 3; k++) {
+			uint v = indicies[best * 3 + k];
+			output.push_back(v);
+			nextCache.push_back(v);
+
+			// swap it to the end of the vertex's remaining triangles, then drop it
+			uint* begin = adjacency.data() + adjacencyStart[v];
+			std::swap(*std::find(begin, begin + remaining[v], (uint)best), begin[remaining[v] - 1]);
+			remaining[v]--;
+		}
+		for (uint v : cache) {
+			if (std::find(nextCache.begin(), nextCache.begin() + 3, v) == nextCache.begin() + 3)
+				nextCache.push_back(v);
+		}
+
+		// vertices past the end fall out of the cache, but their score still needs updating
+		for (uint i = 0; i < nextCache.size(); i++) {
+			uint v = nextCache[i];
+			cachePosition[v] = i < forsythCacheSize ? i : -1;
+			scores[v] = vertexScore(cachePosition[v], remaining[v]);
+		}
+
+		// only triangles touching the cache could have changed, so the best one is among them
+		best = -1;
+		float bestScore = -1;
+		for (uint v : nextCache) {
+			if (cachePosition[v] < 0) continue;
+			for (uint i = 0; i < remaining[v]; i++) {
+				uint t = adjacency[adjacencyStart[v] + i];
+				float score = triangleScore(t);
+				if (score > bestScore) {
+					best = t;
+					bestScore = score;
+				}
+			}
+		}
+
+		nextCache.resize(std::min<size_t>(nextCache.size(), forsythCacheSize));
+		std::swap(cache, nextCache);
+	}
+
+	return output;
+}
+
+// Splits the triangles into clusters that can be drawn in any order without costing much more
+// than threshold times as many cache misses. Returns where each cluster starts, in triangles.
+static std::vector<uint> overdrawClusters(const std::span<const uint> indicies,
+                                          const uint vertexCount, const float threshold) {
+	const uint triangleCount = indicies.size() / 3;
+	FifoCache cache{vertexCount, forsythCacheSize};
+
+	// missing all three vertices almost always means the optimizer started a new patch, and the
+	// mesh can be split there for free
+	std::vector<uint> hard;
+	for (uint t = 0; t < triangleCount; t++) {
+		if (cache.accessTriangle(&indicies[t * 3]) == 3 or t == 0) hard.push_back(t);
+	}
+	hard.push_back(triangleCount);
+
+	// Patches are split further wherever the part so far has a miss ratio within threshold of
+	// the whole patch's. The cache is flushed at each split, since the next part could be drawn
+	// after anything.
+	std::vector<uint> clusters;
+	for (uint i = 0; i + 1 < hard.size(); i++) {
+		const uint begin = hard[i];
+		const uint end = hard[i + 1];
+
+		cache.flush();
+		ulong start = cache.getMisses();
+		for (uint t = begin; t < end; t++) cache.accessTriangle(&indicies[t * 3]);
+		float target = threshold * (cache.getMisses() - start) / (end - begin);
+
+		clusters.push_back(begin);
+		cache.flush();
+		uint misses = 0;
+		uint triangles = 0;
+		for (uint t = begin; t < end; t++) {
+			misses += cache.accessTriangle(&indicies[t * 3]);
+			triangles++;
+			if (t + 1 < end and (float)misses / triangles <= target) {
+				clusters.push_back(t + 1);
+				cache.flush();
+				misses = 0;
+				triangles = 0;
+			}
+		}
+	}
+	clusters.push_back(triangleCount);
+	return clusters;
+}
+
+std::vector<uint> optimizeOverdraw(const std::span<const uint> indicies,
+                                   const std::span<const glm::vec3> positions,
+                                   const float threshold) {
+	std::vector<uint> clusters = overdrawClusters(indicies, positions.size(), threshold);
+	const uint clusterCount = clusters.size() - 1;
+
+	glm::vec3 meshCentroid{0};
+	for (uint index : indicies) meshCentroid += positions[index];
+	meshCentroid /= (float)indicies.size();
+
+	// Clusters facing away from the middle of the mesh are drawn first. They're on the outside,
+	// so they're the most likely to hide the others.
+	std::vector<float> facingOut(clusterCount);
+	for (uint c = 0; c < clusterCount; c++) {
+		glm::vec3 centroid{0};
+		glm::vec3 normal{0};
+		float area = 0;
+		for (uint t = clusters[c]; t < clusters[c + 1]; t++) {
+			const glm::vec3& p0 = positions[indicies[t * 3]];
+			const glm::vec3& p1 = positions[indicies[t * 3 + 1]];
+			const glm::vec3& p2 = positions[indicies[t * 3 + 2]];
+			// twice the area, pointing along the normal
+			glm::vec3 weighted = glm::cross(p1 - p0, p2 - p0);
+			float triangleArea = glm::length(weighted);
+			centroid += (p0 + p1 + p2) * (triangleArea / 3);
+			normal += weighted;
+			area += triangleArea;
+		}
+		if (area > 0) centroid /= area;
+		float normalLength = glm::length(normal);
+		if (normalLength > 0) normal /= normalLength;
+		facingOut[c] = glm::dot(centroid - meshCentroid, normal);
+	}
+
+	std::vector<uint> order(clusterCount);
+	std::iota(ALL_OF(order), 0);
+	std::ranges::stable_sort(order, std::greater{}, [&](const uint c) { return facingOut[c]; });
+
+	std::vector<uint> output;
+	output.reserve(indicies.size());
+	for (uint c : order) {
+		output.insert(output.end(), indicies.begin() + clusters[c] * 3,
+		              indicies.begin() + clusters[c + 1] * 3);
+	}
+	return output;
+}
+
+std::vector<uint> optimizeVertexFetch(const std::span<uint> indicies, const uint vertexCount) {
+	std::vector<uint> remap(vertexCount, unusedVertex);
+	uint next = 0;
+	for (uint& index : indicies) {
+		if (remap[index] == unusedVertex) remap[index] = next++;
+		index = remap[index];
+	}
+	return remap;
+}
@@ -0,0 +1,44 @@
+#ifndef VERTEXCACHE_HPP
+#define VERTEXCACHE_HPP
+
+#include "common.hpp"
+
+#include <glm/ext/vector_float3.hpp>
+
+#include <limits>
+#include <span>
+#include <vector>
+
+// how well an index order uses the GPU's post-transform vertex cache
+struct VertexCacheStats {
+	double acmr; // average cache miss ratio: vertices transformed per triangle, 0.5 at best
+	double atvr; // average transform to vertex ratio: vertices transformed per vertex, 1 at best
+};
+
+// Runs indicies through a FIFO cache of cacheSize vertices, like most GPUs have. vertexCount is
+// how many vertices the indicies refer to.
+VertexCacheStats simulateVertexCache(const std::span<const uint> indicies, const uint vertexCount,
+                                     const uint cacheSize = 32);
+
+// Reorders triangles so vertices are reused while they're still cached, with Tom Forsyth's
+// "linear-speed vertex cache optimisation". The triangles themselves and their winding don't
+// change, only the order they're drawn in.
+std::vector<uint> optimizeVertexCache(const std::span<const uint> indicies,
+                                      const uint vertexCount);
+
+// Reorders triangles to cut overdraw, without knowing where the camera is. indicies should
+// already be optimized for the vertex cache: they're split into clusters that each keep most of
+// their cache reuse, and the clusters on the outside of the mesh are drawn first, so they hide
+// more of the inside. threshold is how many times worse the cache miss ratio can get, like 1.05.
+std::vector<uint> optimizeOverdraw(const std::span<const uint> indicies,
+                                   const std::span<const glm::vec3> positions,
+                                   const float threshold);
+
+// marks a vertex nothing uses, in optimizeVertexFetch's remap
+constexpr uint unusedVertex = std::numeric_limits<uint>::max();
+
+// Renumbers vertices in the order indicies first use them, so they're fetched from memory mostly
+// in order, and rewrites indicies to match. Returns each old vertex's new index, or unusedVertex.
+std::vector<uint> optimizeVertexFetch(const std::span<uint> indicies, const uint vertexCount);
+
+#endif /* VERTEXCACHE_HPP */